@@ -1,42 +1,154 @@
 #include "bench/echo/bench.h"
 
+#include <deque>
 #include <exception>
+#include <vector>
 
-#include "absl/time/clock.h"
+#include "puddle/internal/sync.h"
+#include "puddle/log/rate_limit.h"
 #include "puddle/net/tcp.h"
+#include "puddle/net/unix.h"
 
 namespace echo {
 
-Benchmark::Benchmark(Config config) : config_{config}, logger_{"bench"} {}
+Benchmark::Benchmark(Config config)
+    : stats_{}, config_{config}, logger_{"bench"} {}
 
 void Benchmark::Run() {
-  auto start = std::chrono::high_resolution_clock::now();
-
-  std::vector<uint64_t> requests_per_client(config_.clients);
-  for (uint64_t i = 0; i != config_.requests; i++) {
-    requests_per_client[i % config_.clients]++;
-  }
+  auto start = std::chrono::steady_clock::now();
+  measure_start_ = start + config_.warmup;
+  end_ = measure_start_ + config_.duration;
 
   std::vector<puddle::Task> tasks;
-  for (uint64_t requests : requests_per_client) {
-    tasks.push_back(puddle::Spawn(&Benchmark::Client, this, requests));
+  for (int i = 0; i != config_.connections; i++) {
+    tasks.push_back(puddle::Spawn(&Benchmark::Client, this, i));
   }
   for (auto& task : tasks) {
     task.Join();
   }
 
-  auto end = std::chrono::high_resolution_clock::now();
-  stats_.duration =
-      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+  stats_.duration = config_.duration;
+}
+
+void Benchmark::Client(int index) {
+  const std::string unix_prefix = "unix:";
+  if (config_.addr.rfind(unix_prefix, 0) == 0) {
+    RunClient(puddle::net::UnixConn::Connect(
+                  config_.addr.substr(unix_prefix.size())),
+              index);
+  } else {
+    RunClient(puddle::net::TcpConn::Connect(config_.addr), index);
+  }
 }
 
-void Benchmark::Client(uint64_t requests) {
-  puddle::net::TcpConn conn = puddle::net::TcpConn::Connect(config_.addr);
+template <typename Conn>
+void Benchmark::RunClient(Conn conn, int index) {
+  using Clock = std::chrono::steady_clock;
+
+  // Time between requests on this connection, or zero for a closed loop.
+  std::chrono::nanoseconds interval{0};
+  if (config_.rate > 0) {
+    interval = std::chrono::nanoseconds{1'000'000'000ULL *
+                                        config_.connections / config_.rate};
+  }
+
+  // Intended send times of the requests in flight, oldest first.
+  std::deque<Clock::time_point> in_flight;
+
+  // Wakes the sender when the pipeline has space.
+  puddle::internal::WaitQueue pipeline_space;
+
+  // Wakes the receiver when a request is sent or sending stops.
+  puddle::internal::WaitQueue request_sent;
+
+  bool sending = true;
+  bool failed = false;
+
+  // Responses are read by a separate task, so requests can be sent while
+  // waiting for responses.
+  puddle::Task receiver = puddle::Spawn([&] {
+    std::string response(config_.request_size, '\0');
+    try {
+      while (true) {
+        while (sending && in_flight.empty()) {
+          request_sent.SuspendAndWait(
+              puddle::internal::Reactor::local()->active());
+        }
+        if (in_flight.empty()) {
+          break;
+        }
+
+        size_t n_read = 0;
+        while (n_read < response.size()) {
+          size_t n =
+              conn.Read(reinterpret_cast<uint8_t*>(response.data() + n_read),
+                        response.size() - n_read);
+          if (n == 0) {
+            throw std::runtime_error{"connection closed"};
+          }
+          n_read += n;
+        }
+
+        auto now = Clock::now();
+        Clock::time_point intended = in_flight.front();
+        in_flight.pop_front();
+        pipeline_space.NotifyOne();
+
+        if (intended >= measure_start_ && intended < end_) {
+          stats_.histogram.Add(
+              std::chrono::duration_cast<std::chrono::microseconds>(now -
+                                                                    intended)
+                  .count());
+          stats_.requests++;
+        }
+      }
+    } catch (const std::exception& e) {
+      // When the server fails every client fails at once, so rate limit to
+      // avoid flooding the log.
+      PUDDLE_LOG_RATE_LIMITED(logger_, puddle::log::Level::kError, 1, 10,
+                              "benchmark client: {}", e.what());
+      failed = true;
+      pipeline_space.NotifyOne();
+    }
+  });
 
   std::string request(config_.request_size, 'x');
   try {
-    for (uint64_t i = 0; i != requests; i++) {
-      int64_t start = absl::GetCurrentTimeNanos();
+    // Stagger the connections so their requests are spread evenly.
+    Clock::time_point next =
+        Clock::now() + interval * index / config_.connections;
+    while (!failed) {
+      if (interval.count() > 0) {
+        if (next >= end_) {
+          break;
+        }
+        if (next > Clock::now()) {
+          puddle::SleepUntil(next);
+        }
+      }
+
+      // If the pipeline is full, an open loop request is sent late, though
+      // its latency is still measured from when it should have been sent.
+      while (!failed && in_flight.size() >= static_cast<size_t>(
+                                                 config_.pipeline)) {
+        pipeline_space.SuspendAndWait(puddle::internal::Reactor::local()
+                                          ->active());
+      }
+      if (failed) {
+        break;
+      }
+
+      // In closed loop mode, requests are sent once there's space in the
+      // pipeline, so latency is measured from when the request is sent.
+      if (interval.count() == 0) {
+        next = Clock::now();
+        if (next >= end_) {
+          break;
+        }
+      }
+
+      in_flight.push_back(next);
+      request_sent.NotifyOne();
 
       size_t n_written = 0;
       while (n_written < request.size()) {
@@ -45,23 +157,19 @@ void Benchmark::Client(uint64_t requests) {
                        request.size() - n_written);
       }
 
-      size_t n_read = 0;
-      while (n_read < request.size()) {
-        size_t n =
-            conn.Read(reinterpret_cast<uint8_t*>(request.data() + n_read),
-                      request.size() - n_read);
-        if (n == 0) {
-          throw std::runtime_error{"connection closed"};
-        }
-        n_read -= n;
-      }
-
-      int64_t duration_ns = absl::GetCurrentTimeNanos() - start;
-      stats_.histogram.Add(duration_ns / 1000);  // us
+      next += interval;
     }
   } catch (const std::exception& e) {
-    logger_.Error("benchmark client: {}", e.what());
+    PUDDLE_LOG_RATE_LIMITED(logger_, puddle::log::Level::kError, 1, 10,
+                            "benchmark client: {}", e.what());
+    failed = true;
   }
+
+  // If sending failed the connection is broken, so the receiver fails too
+  // rather than waiting for the remaining responses.
+  sending = false;
+  request_sent.NotifyOne();
+  receiver.Join();
 }
 
 }  // namespace echo
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <string>
 
 #include "puddle/log/log.h"
@@ -9,23 +10,51 @@
 namespace echo {
 
 struct Config {
+  // Server address, either ip:port for TCP, or unix:path for a Unix domain
+  // socket (where path may be prefixed with '@' for the abstract namespace).
   std::string addr;
 
-  uint64_t requests;
+  // Target request rate across all connections in requests per second, or 0
+  // to send requests as fast as the pipeline allows (closed loop).
+  uint64_t rate;
+
+  int connections;
+
+  // Maximum number of requests in flight on each connection.
+  int pipeline;
 
   uint64_t request_size;
 
-  int clients;
+  // Time to send requests before measuring, to warm up the server and
+  // connections.
+  std::chrono::nanoseconds warmup;
+
+  // Time to measure after the warmup.
+  std::chrono::nanoseconds duration;
 
   puddle::Config reactor;
 };
 
 struct Stats {
+  // Latency in microseconds.
   puddle::stats::Histogram histogram;
 
+  // Number of requests sent during the measurement that received a response.
+  uint64_t requests;
+
   std::chrono::nanoseconds duration;
 };
 
+// Benchmark is a load generator for an echo server.
+//
+// With a target rate, the benchmark is open loop: each connection sends
+// requests at scheduled times regardless of whether earlier responses have
+// arrived (up to the pipeline depth). Latency is measured from the time the
+// request was scheduled to be sent rather than when it was actually sent, so
+// if the server stalls, the requests that would have been sent during the
+// stall are counted with their full delay. This avoids coordinated omission,
+// where a closed loop client that waits for each response before sending the
+// next hides latency when the server is saturated.
 class Benchmark {
  public:
   Benchmark(Config config);
@@ -35,12 +64,21 @@ class Benchmark {
   void Run();
 
  private:
-  void Client(uint64_t requests);
+  void Client(int index);
+
+  template <typename Conn>
+  void RunClient(Conn conn, int index);
 
   Stats stats_;
 
   Config config_;
 
+  // Time the measurement starts, after the warmup.
+  std::chrono::steady_clock::time_point measure_start_;
+
+  // Time to stop sending requests.
+  std::chrono::steady_clock::time_point end_;
+
   puddle::log::Logger logger_;
 };
 
@@ -1,11 +1,42 @@
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/time/time.h"
 #include "bench/echo/bench.h"
 
+ABSL_FLAG(std::string, addr, "127.0.0.1:4411",
+          "Server address, either ip:port or unix:path (such as "
+          "unix:@puddle-echo to benchmark examples/echo over a Unix domain "
+          "socket)");
+ABSL_FLAG(uint64_t, rate, 0,
+          "Target requests per second across all connections, or 0 to send "
+          "as fast as possible (closed loop)");
+ABSL_FLAG(int, connections, 10, "Number of connections");
+ABSL_FLAG(int, pipeline, 1, "Maximum requests in flight per connection");
+ABSL_FLAG(uint64_t, request_size, 64, "Request size in bytes");
+ABSL_FLAG(absl::Duration, warmup, absl::Seconds(2),
+          "Time to send requests before measuring");
+ABSL_FLAG(absl::Duration, duration, absl::Seconds(10), "Time to measure");
+ABSL_FLAG(bool, json, false,
+          "Write the results as a single line of JSON, such as for "
+          "bench/harness.py");
+
+// Usage: echo [--addr=127.0.0.1:4411] [--rate=0] [--connections=10]
+//   [--pipeline=1] [--request_size=64] [--warmup=2s] [--duration=10s]
+//   [--json]
+//
+// With --rate, requests are sent open loop at the target rate and latency is
+// measured from each requests scheduled send time (see echo::Benchmark).
 int main(int argc, char* argv[]) {
+  absl::ParseCommandLine(argc, argv);
+
   echo::Config config;
-  config.addr = "127.0.0.1:4411";
-  config.requests = 1'000'000;
-  config.request_size = 64;
-  config.clients = 10;
+  config.addr = absl::GetFlag(FLAGS_addr);
+  config.rate = absl::GetFlag(FLAGS_rate);
+  config.connections = absl::GetFlag(FLAGS_connections);
+  config.pipeline = absl::GetFlag(FLAGS_pipeline);
+  config.request_size = absl::GetFlag(FLAGS_request_size);
+  config.warmup = absl::ToChronoNanoseconds(absl::GetFlag(FLAGS_warmup));
+  config.duration = absl::ToChronoNanoseconds(absl::GetFlag(FLAGS_duration));
   config.reactor = puddle::Config::Default();
 
   // Start the Puddle runtime.
@@ -18,14 +49,28 @@ int main(int argc, char* argv[]) {
   bench.Run();
 
   auto stats = bench.stats();
-  auto milliseconds =
-      std::chrono::duration_cast<std::chrono::milliseconds>(stats.duration)
-          .count();
-  auto request_per_ms = config.requests / milliseconds;
+  double requests_per_second =
+      stats.requests / std::chrono::duration<double>(stats.duration).count();
+
+  if (absl::GetFlag(FLAGS_json)) {
+    fmt::println(
+        R"({{"rate":{},"connections":{},"pipeline":{},"request_size":{},)"
+        R"("requests":{},"requests_per_second":{:.0f},"latency_us":{{"min":{},)"
+        R"("p50":{},"p99":{},"p99.9":{},"p99.99":{},"max":{},)"
+        R"("stddev":{:.2f}}}}})",
+        config.rate, config.connections, config.pipeline,
+        config.request_size, stats.requests, requests_per_second,
+        stats.histogram.min(), stats.histogram.Percentile(50.0),
+        stats.histogram.Percentile(99.0), stats.histogram.Percentile(99.9),
+        stats.histogram.Percentile(99.99), stats.histogram.max(),
+        stats.histogram.StdDev());
+    return 0;
+  }
 
   fmt::println(
       R"(
-  Requests per second: {}
+  Target requests per second: {}
+  Requests per second: {:.0f}
 
   Latency (us):
     Min: {}
@@ -36,7 +81,8 @@ int main(int argc, char* argv[]) {
     Max: {}
     Std dev: {:.2f}
 )",
-      request_per_ms * 1000, stats.histogram.min(),
+      config.rate > 0 ? std::to_string(config.rate) : "unlimited",
+      requests_per_second, stats.histogram.min(),
       stats.histogram.Percentile(50.0), stats.histogram.Percentile(99.0),
       stats.histogram.Percentile(99.9), stats.histogram.Percentile(99.99),
       stats.histogram.max(), stats.histogram.StdDev());
@@ -0,0 +1,140 @@
+// Echo server benchmark target.
+//
+// A TCP echo server for bench/echo, so benchmarks don't depend on
+// examples/echo. Unlike the example, it runs a reactor per thread, reads with
+// a large buffer, and doesn't log per connection.
+//
+// Usage: echo_server [--addr=:4411] [--threads=1] [--cpu=-1]
+//   [--buffer_size=16384] [--ring_mode=default]
+//
+// With --threads > 1, each thread accepts from its own SO_REUSEPORT listener.
+// With --cpu, thread i is pinned to CPU cpu + i.
+
+#include <liburing.h>
+
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "puddle/log/log.h"
+#include "puddle/log/rate_limit.h"
+#include "puddle/net/tcp.h"
+#include "puddle/puddle.h"
+
+ABSL_FLAG(std::string, addr, ":4411", "Address to listen on");
+ABSL_FLAG(int, threads, 1, "Number of reactor threads");
+ABSL_FLAG(int, cpu, -1,
+          "CPU to pin the first reactor thread to, or -1 to not pin threads");
+ABSL_FLAG(size_t, buffer_size, 16384, "Read buffer size in bytes");
+ABSL_FLAG(std::string, ring_mode, "default",
+          "io_uring setup mode: default, coop (IORING_SETUP_COOP_TASKRUN), "
+          "defer (IORING_SETUP_DEFER_TASKRUN) or sqpoll "
+          "(IORING_SETUP_SQPOLL)");
+
+namespace {
+
+unsigned RingFlags(const std::string& mode) {
+  if (mode == "default") {
+    return 0;
+  }
+  if (mode == "coop") {
+    return IORING_SETUP_COOP_TASKRUN;
+  }
+  if (mode == "defer") {
+    return IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+  }
+  if (mode == "sqpoll") {
+    return IORING_SETUP_SQPOLL;
+  }
+  throw std::invalid_argument{"unknown ring mode: " + mode};
+}
+
+void Conn(puddle::net::TcpConn conn, size_t buffer_size) {
+  std::vector<uint8_t> buf(buffer_size);
+  try {
+    while (true) {
+      size_t read_n = conn.Read(buf.data(), buf.size());
+      if (read_n == 0) {
+        return;
+      }
+
+      size_t write_n = 0;
+      while (write_n < read_n) {
+        write_n += conn.Write(buf.data() + write_n, read_n - write_n);
+      }
+    }
+  } catch (const std::exception& e) {
+    // Clients reset connections when the benchmark ends, so ignore errors.
+  }
+}
+
+// Starts a reactor on the calling thread, then serves connections from the
+// listener.
+void Serve(puddle::net::TcpListener listener, puddle::Config config) {
+  puddle::Start(config);
+
+  size_t buffer_size = absl::GetFlag(FLAGS_buffer_size);
+  puddle::log::Logger logger{"serve"};
+  while (true) {
+    try {
+      auto conn = listener.Accept();
+      puddle::Spawn(Conn, std::move(conn), buffer_size).Detach();
+    } catch (const std::system_error& e) {
+      // Accept errors are transient (such as a connection aborted before
+      // being accepted), so keep serving.
+      PUDDLE_LOG_RATE_LIMITED(logger, puddle::log::Level::kWarn, 1, 10,
+                              "accept: {}", e.what());
+      if (e.code().value() == EMFILE || e.code().value() == ENFILE) {
+        // Wait for connections to close and release descriptors.
+        puddle::SleepFor(std::chrono::milliseconds{100});
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::ParseCommandLine(argc, argv);
+
+  std::string addr = absl::GetFlag(FLAGS_addr);
+  int threads = absl::GetFlag(FLAGS_threads);
+  int cpu = absl::GetFlag(FLAGS_cpu);
+
+  puddle::Config config = puddle::Config::Default();
+  config.reactor.ring_flags = RingFlags(absl::GetFlag(FLAGS_ring_mode));
+
+  std::vector<puddle::net::TcpListener> listeners;
+  if (threads == 1) {
+    listeners.push_back(puddle::net::TcpListener::Bind(addr, 1024));
+  } else {
+    listeners = puddle::net::TcpListener::BindSharded(addr, 1024, threads);
+  }
+
+  puddle::log::Logger logger{"main"};
+  logger.Info("starting echo server; addr = {}, threads = {}, ring mode = {}",
+              addr, threads, absl::GetFlag(FLAGS_ring_mode));
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i != threads; i++) {
+    puddle::Config thread_config = config;
+    // Listener i receives connections processed by CPUs equal to i modulo
+    // the number of threads, so give each thread the listener for its CPU.
+    size_t listener = i;
+    if (cpu != -1) {
+      thread_config.reactor.cpu = cpu + i;
+      listener = (cpu + i) % threads;
+    }
+    workers.emplace_back(Serve, std::move(listeners[listener]),
+                         thread_config);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Echo benchmark harness.
+
+Runs bench/echo against bench/echo_server, sweeping the number of
+connections, request size and io_uring ring mode, and writes the results as
+JSON and CSV so runs can be compared across Puddle versions.
+
+The server and client are pinned to separate CPUs with taskset, so they don't
+compete for the same cores.
+
+Build the benchmarks first:
+  bazel build -c opt //bench/echo //bench/echo_server
+
+Then run, such as:
+  bench/harness.py --connections=1,10,100 --request-sizes=64,4096 \\
+      --ring-modes=default,coop --output=results
+"""
+
+import argparse
+import csv
+import datetime
+import json
+import os
+import platform
+import socket
+import subprocess
+import sys
+import time
+
+
+def parse_list(value, type_=str):
+    return [type_(v) for v in value.split(",") if v]
+
+
+def wait_for_port(port, timeout=10.0):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            with socket.create_connection(("127.0.0.1", port), timeout=1):
+                return
+        except OSError:
+            time.sleep(0.05)
+    raise RuntimeError(f"server not listening on port {port}")
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(
+            ["git", "describe", "--always", "--dirty"], text=True
+        ).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def start_server(args, ring_mode):
+    cmd = [
+        "taskset",
+        "-c",
+        args.server_cpus,
+        args.server,
+        f"--addr=:{args.port}",
+        f"--threads={args.server_threads}",
+        f"--ring_mode={ring_mode}",
+    ]
+    server = subprocess.Popen(
+        cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL
+    )
+    try:
+        wait_for_port(args.port)
+    except RuntimeError:
+        server.kill()
+        raise
+    return server
+
+
+def run_client(args, connections, request_size):
+    cmd = [
+        "taskset",
+        "-c",
+        args.client_cpus,
+        args.client,
+        f"--addr=127.0.0.1:{args.port}",
+        f"--connections={connections}",
+        f"--request_size={request_size}",
+        f"--pipeline={args.pipeline}",
+        f"--rate={args.rate}",
+        f"--warmup={args.warmup}",
+        f"--duration={args.duration}",
+        "--json",
+    ]
+    output = subprocess.check_output(cmd, text=True)
+    # The result is the last JSON line, after any logs.
+    for line in reversed(output.splitlines()):
+        if line.startswith("{"):
+            return json.loads(line)
+    raise RuntimeError(f"no result from client: {output}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        "--server", default="bazel-bin/bench/echo_server/echo_server"
+    )
+    parser.add_argument("--client", default="bazel-bin/bench/echo/echo")
+    parser.add_argument("--port", type=int, default=4411)
+    parser.add_argument("--server-cpus", default="0")
+    parser.add_argument("--client-cpus", default="1")
+    parser.add_argument("--server-threads", type=int, default=1)
+    parser.add_argument("--connections", default="1,10,100")
+    parser.add_argument("--request-sizes", default="64,1024,16384")
+    parser.add_argument("--ring-modes", default="default,coop,defer")
+    parser.add_argument("--pipeline", type=int, default=1)
+    parser.add_argument(
+        "--rate", type=int, default=0, help="target rate, or 0 for closed loop"
+    )
+    parser.add_argument("--warmup", default="2s")
+    parser.add_argument("--duration", default="10s")
+    parser.add_argument(
+        "--output",
+        default="echo-results",
+        help="output path prefix, writing <output>.json and <output>.csv",
+    )
+    args = parser.parse_args()
+
+    metadata = {
+        "revision": git_revision(),
+        "time": datetime.datetime.now(datetime.timezone.utc).isoformat(),
+        "host": platform.node(),
+        "kernel": platform.release(),
+        "cpus": os.cpu_count(),
+        "server_cpus": args.server_cpus,
+        "client_cpus": args.client_cpus,
+        "server_threads": args.server_threads,
+    }
+
+    results = []
+    for ring_mode in parse_list(args.ring_modes):
+        server = start_server(args, ring_mode)
+        try:
+            for connections in parse_list(args.connections, int):
+                for request_size in parse_list(args.request_sizes, int):
+                    result = run_client(args, connections, request_size)
+                    result["ring_mode"] = ring_mode
+                    results.append(result)
+                    print(
+                        f"ring_mode={ring_mode} connections={connections} "
+                        f"request_size={request_size}: "
+                        f"{result['requests_per_second']} req/s, "
+                        f"p99 {result['latency_us']['p99']}us",
+                        file=sys.stderr,
+                    )
+        finally:
+            server.kill()
+            server.wait()
+
+    with open(args.output + ".json", "w") as f:
+        json.dump({"metadata": metadata, "results": results}, f, indent=2)
+
+    fields = [
+        "ring_mode",
+        "connections",
+        "request_size",
+        "pipeline",
+        "rate",
+        "requests",
+        "requests_per_second",
+    ]
+    latency_fields = ["min", "p50", "p99", "p99.9", "p99.99", "max", "stddev"]
+    with open(args.output + ".csv", "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(
+            ["revision"] + fields + [f"latency_us_{l}" for l in latency_fields]
+        )
+        for result in results:
+            writer.writerow(
+                [metadata["revision"]]
+                + [result[field] for field in fields]
+                + [result["latency_us"][l] for l in latency_fields]
+            )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,147 @@
+// Relay benchmark.
+//
+// Measures the throughput and CPU cost of relaying bytes between two
+// connections, comparing copying via a user space buffer (TcpConn::Read and
+// TcpConn::Write) with splicing (net::Pipe).
+//
+// A source task writes to the relay, which forwards the bytes to a sink task
+// that discards them. All tasks run on the same reactor, so CPU time includes
+// the source and sink, though they are the same for both modes.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "puddle/log/log.h"
+#include "puddle/net/splice.h"
+#include "puddle/net/tcp.h"
+#include "puddle/puddle.h"
+
+namespace {
+
+struct Config {
+  std::string relay_addr;
+
+  std::string sink_addr;
+
+  // Total bytes to relay.
+  uint64_t bytes;
+
+  // Size of the buffer used by the source, sink and copying relay.
+  size_t buffer_size;
+};
+
+struct Result {
+  std::chrono::nanoseconds duration;
+
+  // CPU time (user and system).
+  std::chrono::nanoseconds cpu;
+};
+
+std::chrono::nanoseconds CpuTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return std::chrono::seconds{usage.ru_utime.tv_sec + usage.ru_stime.tv_sec} +
+         std::chrono::microseconds{usage.ru_utime.tv_usec +
+                                   usage.ru_stime.tv_usec};
+}
+
+void WriteAll(puddle::net::TcpConn& conn, const uint8_t* buf, size_t size) {
+  size_t n_written = 0;
+  while (n_written < size) {
+    n_written += conn.Write(buf + n_written, size - n_written);
+  }
+}
+
+void Copy(puddle::net::TcpConn& from, puddle::net::TcpConn& to,
+          size_t buffer_size) {
+  std::vector<uint8_t> buf(buffer_size);
+  while (true) {
+    size_t n = from.Read(buf.data(), buf.size());
+    if (n == 0) {
+      return;
+    }
+    WriteAll(to, buf.data(), n);
+  }
+}
+
+Result Run(const Config& config, puddle::net::TcpListener& relay_listener,
+           puddle::net::TcpListener& sink_listener, bool splice) {
+  auto start = std::chrono::steady_clock::now();
+  auto cpu_start = CpuTime();
+
+  puddle::Task sink = puddle::Spawn([&] {
+    puddle::net::TcpConn conn = sink_listener.Accept();
+    std::vector<uint8_t> buf(config.buffer_size);
+    while (conn.Read(buf.data(), buf.size()) != 0) {
+    }
+  });
+
+  puddle::Task relay = puddle::Spawn([&] {
+    puddle::net::TcpConn from = relay_listener.Accept();
+    puddle::net::TcpConn to = puddle::net::TcpConn::Connect(config.sink_addr);
+    if (splice) {
+      puddle::net::Pipe(from, to);
+    } else {
+      Copy(from, to, config.buffer_size);
+    }
+  });
+
+  {
+    puddle::net::TcpConn conn =
+        puddle::net::TcpConn::Connect(config.relay_addr);
+    std::vector<uint8_t> buf(config.buffer_size, 'x');
+    uint64_t n_written = 0;
+    while (n_written < config.bytes) {
+      size_t n = std::min<uint64_t>(buf.size(), config.bytes - n_written);
+      WriteAll(conn, buf.data(), n);
+      n_written += n;
+    }
+  }
+
+  relay.Join();
+  sink.Join();
+
+  Result result;
+  result.duration = std::chrono::steady_clock::now() - start;
+  result.cpu = CpuTime() - cpu_start;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Config config;
+  config.relay_addr = "127.0.0.1:4412";
+  config.sink_addr = "127.0.0.1:4413";
+  config.bytes = 4ULL * 1024 * 1024 * 1024;
+  config.buffer_size = 64 * 1024;
+
+  // Start the Puddle runtime.
+  puddle::Start();
+
+  puddle::log::Logger logger{"main"};
+  logger.Info("starting benchmark");
+
+  auto relay_listener = puddle::net::TcpListener::Bind(config.relay_addr, 128);
+  auto sink_listener = puddle::net::TcpListener::Bind(config.sink_addr, 128);
+
+  for (bool splice : {false, true}) {
+    Result result = Run(config, relay_listener, sink_listener, splice);
+
+    double seconds = std::chrono::duration<double>(result.duration).count();
+    double cpu_seconds = std::chrono::duration<double>(result.cpu).count();
+    double gb = static_cast<double>(config.bytes) / (1024 * 1024 * 1024);
+
+    fmt::println(
+        R"(
+  Mode: {}
+    Throughput (GB/s): {:.2f}
+    CPU per GB (ms): {:.2f}
+)",
+        splice ? "splice" : "copy", gb / seconds, cpu_seconds * 1000 / gb);
+  }
+}
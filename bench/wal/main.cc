@@ -0,0 +1,101 @@
+// WAL benchmark.
+//
+// Measures the number of durable appends (commits) per second to a
+// write-ahead log with 1, 16 and 256 concurrent writers.
+//
+// Usage: wal [path]
+//
+// Writes to /tmp/puddle-wal-bench by default. Note /tmp is often tmpfs, where
+// syncs are free, so pass a path on a local disk to measure a real device.
+
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "puddle/fs/file.h"
+#include "puddle/fs/wal.h"
+#include "puddle/log/log.h"
+#include "puddle/puddle.h"
+
+namespace {
+
+struct Config {
+  std::string path;
+
+  // Size of each appended record.
+  size_t record_size;
+
+  // Duration to run each benchmark.
+  std::chrono::seconds duration;
+};
+
+struct Result {
+  uint64_t appends;
+
+  uint64_t commits;
+
+  std::chrono::nanoseconds duration;
+};
+
+Result Run(const Config& config, int writers) {
+  unlink(config.path.c_str());
+  puddle::fs::Wal wal{puddle::fs::File::Open(config.path, O_WRONLY | O_CREAT)};
+
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + config.duration;
+
+  uint64_t appends = 0;
+  std::vector<puddle::Task> tasks;
+  for (int i = 0; i != writers; i++) {
+    tasks.push_back(puddle::Spawn([&] {
+      std::vector<uint8_t> record(config.record_size, 'x');
+      while (std::chrono::steady_clock::now() < end) {
+        wal.Append(record.data(), record.size());
+        appends++;
+      }
+    }));
+  }
+  for (auto& task : tasks) {
+    task.Join();
+  }
+
+  Result result;
+  result.appends = appends;
+  result.commits = wal.commits();
+  result.duration = std::chrono::steady_clock::now() - start;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Config config;
+  config.path = argc > 1 ? argv[1] : "/tmp/puddle-wal-bench";
+  config.record_size = 128;
+  config.duration = std::chrono::seconds{5};
+
+  // Start the Puddle runtime.
+  puddle::Start();
+
+  puddle::log::Logger logger{"main"};
+  logger.Info("starting benchmark; path = {}", config.path);
+
+  for (int writers : {1, 16, 256}) {
+    Result result = Run(config, writers);
+
+    double seconds = std::chrono::duration<double>(result.duration).count();
+    fmt::println(
+        R"(
+  Writers: {}
+    Appends per second: {:.0f}
+    Commits per second: {:.0f}
+    Appends per commit: {:.2f}
+)",
+        writers, result.appends / seconds, result.commits / seconds,
+        static_cast<double>(result.appends) / result.commits);
+  }
+
+  unlink(config.path.c_str());
+}
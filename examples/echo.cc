@@ -1,18 +1,26 @@
 // Echo example.
 //
-// This example provides a simple echo server. Connect to the server with
-// `nc localhost 4411`.
+// This example provides a simple echo server, listening on both TCP and a
+// Unix domain socket in the abstract namespace. Connect to the server with
+// `nc localhost 4411` or `socat - ABSTRACT-CONNECT:puddle-echo`.
+//
+// Runtime metrics are served at `http://localhost:4412/metrics`.
 
 #include <array>
+#include <chrono>
 #include <csignal>
-#include <iostream>
 
+#include "puddle/admin.h"
 #include "puddle/log/log.h"
+#include "puddle/log/rate_limit.h"
 #include "puddle/net/tcp.h"
+#include "puddle/net/unix.h"
 #include "puddle/puddle.h"
 #include "puddle/signal.h"
 
-void Conn(puddle::net::TcpConn conn) {
+template <typename C>
+void Conn(C conn) {
+  static puddle::log::Logger logger{"conn"};
   std::array<uint8_t, 256> buf;
   while (true) {
     try {
@@ -27,27 +35,48 @@ void Conn(puddle::net::TcpConn conn) {
         write_n += conn.Write(buf.data() + write_n, read_n - write_n);
       }
     } catch (const std::exception& e) {
-      std::cout << "client error: " << e.what() << std::endl;
+      // Rate limit as a misbehaving client could flood the log.
+      PUDDLE_LOG_RATE_LIMITED(logger, puddle::log::Level::kWarn, 1, 10,
+                              "client error: {}", e.what());
+      return;
     }
   }
 }
 
 int main(int argc, char* argv[]) {
-  // Start the Puddle runtime.
-  puddle::Start();
+  // Start the Puddle runtime, reporting tasks that block the reactor for
+  // over 100ms.
+  puddle::Config config = puddle::Config::Default();
+  config.reactor.stall_threshold = std::chrono::milliseconds{100};
+  puddle::Start(config);
 
   puddle::log::Logger logger{"main"};
   logger.Info("starting echo server; addr = {}", ":4411");
 
   auto listener = puddle::net::TcpListener::Bind(":4411", 128);
 
+  logger.Info("starting echo server; addr = {}", "@puddle-echo");
+
+  auto unix_listener = puddle::net::UnixListener::Bind("@puddle-echo", 128);
+
+  logger.Info("starting admin server; addr = {}", ":4412");
+
+  puddle::ServeAdmin(":4412").Detach();
+
   puddle::NotifySignal({SIGINT, SIGTERM}, [&](int signal) {
     logger.Info("shutting down; signal = {}", strsignal(signal));
     exit(EXIT_SUCCESS);
   });
 
+  puddle::Spawn([&] {
+    while (true) {
+      auto conn = unix_listener.Accept();
+      puddle::Spawn(Conn<puddle::net::UnixConn>, std::move(conn)).Detach();
+    }
+  }).Detach();
+
   while (true) {
     auto conn = listener.Accept();
-    puddle::Spawn(Conn, std::move(conn)).Detach();
+    puddle::Spawn(Conn<puddle::net::TcpConn>, std::move(conn)).Detach();
   }
 }
@@ -0,0 +1,134 @@
+#include "puddle/admin.h"
+
+#include <cerrno>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+#include "puddle/internal/trace.h"
+#include "puddle/log/log.h"
+#include "puddle/log/rate_limit.h"
+#include "puddle/net/buffered.h"
+#include "puddle/net/tcp.h"
+#include "puddle/puddle.h"
+#include "puddle/stats/prometheus.h"
+
+namespace puddle {
+
+namespace {
+
+// Limits on the request, so a client can't make the admin server buffer
+// unbounded data.
+constexpr size_t kMaxRequestLine = 8192;
+constexpr size_t kMaxHeaderLine = 8192;
+constexpr int kMaxHeaders = 100;
+
+void WriteResponse(net::BufferedConn* conn, std::string_view status,
+                   std::string_view content_type, std::string_view body) {
+  std::string header = "HTTP/1.1 ";
+  header += status;
+  header += "\r\nContent-Type: ";
+  header += content_type;
+  header += "\r\nContent-Length: ";
+  header += std::to_string(body.size());
+  header += "\r\nConnection: close\r\n\r\n";
+
+  conn->Write(reinterpret_cast<const uint8_t*>(header.data()), header.size());
+  conn->Write(reinterpret_cast<const uint8_t*>(body.data()), body.size());
+  conn->Flush();
+}
+
+// Serves a single request then closes the connection.
+void ServeConn(net::TcpConn tcp_conn) {
+  static log::Logger logger{"admin"};
+  try {
+    net::BufferedConn conn{std::move(tcp_conn)};
+
+    std::string request_line;
+    try {
+      if (!conn.ReadLine(&request_line, kMaxRequestLine)) {
+        return;
+      }
+    } catch (const std::length_error& e) {
+      WriteResponse(&conn, "400 Bad Request", "text/plain",
+                    "request line too long\n");
+      return;
+    }
+
+    // Discard the headers, which end with an empty line.
+    std::string header;
+    int headers = 0;
+    try {
+      while (conn.ReadLine(&header, kMaxHeaderLine) && header != "\r" &&
+             !header.empty()) {
+        if (++headers > kMaxHeaders) {
+          WriteResponse(&conn, "431 Request Header Fields Too Large",
+                        "text/plain", "too many headers\n");
+          return;
+        }
+      }
+    } catch (const std::length_error& e) {
+      WriteResponse(&conn, "431 Request Header Fields Too Large",
+                    "text/plain", "header too long\n");
+      return;
+    }
+
+    // Request line is "<method> <path> <version>".
+    std::string_view request{request_line};
+    size_t method_end = request.find(' ');
+    size_t path_end = request.find(' ', method_end + 1);
+    if (method_end == std::string_view::npos ||
+        path_end == std::string_view::npos) {
+      WriteResponse(&conn, "400 Bad Request", "text/plain", "bad request\n");
+      return;
+    }
+    std::string_view method = request.substr(0, method_end);
+    std::string_view path =
+        request.substr(method_end + 1, path_end - method_end - 1);
+
+    if (method == "GET" && path == "/metrics") {
+      WriteResponse(&conn, "200 OK", "text/plain; version=0.0.4",
+                    stats::FormatPrometheus());
+#ifdef PUDDLE_TASK_TRACING
+    } else if (method == "GET" && path == "/trace") {
+      WriteResponse(&conn, "200 OK", "application/json",
+                    internal::FormatChromeTrace());
+#endif
+    } else {
+      WriteResponse(&conn, "404 Not Found", "text/plain", "not found\n");
+    }
+  } catch (const std::exception& e) {
+    logger.Debug("admin connection: {}", e.what());
+  }
+}
+
+void Accept(net::TcpListener listener) {
+  static log::Logger logger{"admin"};
+  while (true) {
+    try {
+      net::TcpConn conn = listener.Accept();
+      Spawn(ServeConn, std::move(conn)).Detach();
+    } catch (const std::system_error& e) {
+      // Accept errors are transient (such as a connection aborted before
+      // being accepted), so keep serving.
+      PUDDLE_LOG_RATE_LIMITED(logger, log::Level::kWarn, 1, 10,
+                              "admin accept: {}", e.what());
+      if (e.code().value() == EMFILE || e.code().value() == ENFILE) {
+        // Wait for connections to close and release descriptors, rather
+        // than retrying immediately.
+        SleepFor(std::chrono::milliseconds{100});
+      }
+    }
+  }
+}
+
+}  // namespace
+
+Task ServeAdmin(const std::string& addr) {
+  net::TcpListener listener = net::TcpListener::Bind(addr, 128);
+  return Spawn(Accept, std::move(listener));
+}
+
+}  // namespace puddle
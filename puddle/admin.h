@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+#include "puddle/task.h"
+
+namespace puddle {
+
+// Binds an admin HTTP listener to addr, then spawns a task on the local
+// reactor to serve it. Throws if the listener can't be bound.
+//
+// The admin server serves the metrics in the global stats::Registry at
+// /metrics in the Prometheus text format, including the runtime metrics of
+// every reactor. Metrics are read with relaxed loads so scraping never blocks
+// the reactors.
+//
+// When built with PUDDLE_TASK_TRACING, the recent events of every reactor
+// are also served at /trace as Chrome trace JSON (see internal/trace.h).
+Task ServeAdmin(const std::string& addr);
+
+}  // namespace puddle
@@ -0,0 +1,69 @@
+#include "puddle/fs/buffer.h"
+
+#include <sys/uio.h>
+
+#include <cstdlib>
+#include <new>
+#include <system_error>
+#include <utility>
+
+#include "puddle/internal/reactor.h"
+
+namespace puddle {
+namespace fs {
+
+AlignedBuffer::AlignedBuffer(size_t size, size_t alignment) {
+  // aligned_alloc requires the size to be a multiple of the alignment.
+  size_ = (size + alignment - 1) / alignment * alignment;
+  data_ = static_cast<uint8_t*>(std::aligned_alloc(alignment, size_));
+  if (data_ == nullptr) {
+    throw std::bad_alloc{};
+  }
+}
+
+AlignedBuffer::~AlignedBuffer() { std::free(data_); }
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer&& b) {
+  std::swap(data_, b.data_);
+  std::swap(size_, b.size_);
+  std::swap(index_, b.index_);
+}
+
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& b) {
+  std::swap(data_, b.data_);
+  std::swap(size_, b.size_);
+  std::swap(index_, b.index_);
+  return *this;
+}
+
+void RegisterBuffers(const std::vector<AlignedBuffer*>& buffers) {
+  std::vector<struct iovec> iovecs;
+  for (AlignedBuffer* buffer : buffers) {
+    iovecs.push_back(iovec{buffer->data(), buffer->size()});
+  }
+
+  int res = internal::Reactor::local()->RegisterBuffers(iovecs.data(),
+                                                        iovecs.size());
+  if (res < 0) {
+    throw std::system_error(-res, std::system_category(), "register buffers");
+  }
+
+  for (size_t i = 0; i != buffers.size(); i++) {
+    buffers[i]->index_ = i;
+  }
+}
+
+void UnregisterBuffers(const std::vector<AlignedBuffer*>& buffers) {
+  int res = internal::Reactor::local()->UnregisterBuffers();
+  if (res < 0) {
+    throw std::system_error(-res, std::system_category(),
+                            "unregister buffers");
+  }
+
+  for (AlignedBuffer* buffer : buffers) {
+    buffer->index_ = -1;
+  }
+}
+
+}  // namespace fs
+}  // namespace puddle
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace puddle {
+namespace fs {
+
+class AlignedBuffer;
+
+void RegisterBuffers(const std::vector<AlignedBuffer*>& buffers);
+void UnregisterBuffers(const std::vector<AlignedBuffer*>& buffers);
+
+// AlignedBuffer is a buffer whose address and size are a multiple of the
+// given alignment, as required to read and write files opened with O_DIRECT.
+class AlignedBuffer {
+ public:
+  // Default alignment, which is the page size so is a multiple of the
+  // logical block size of most devices.
+  static constexpr size_t kDefaultAlignment = 4096;
+
+  AlignedBuffer() = default;
+
+  // Allocates a buffer of at least size bytes, rounded up to a multiple of
+  // the alignment.
+  AlignedBuffer(size_t size, size_t alignment = kDefaultAlignment);
+
+  ~AlignedBuffer();
+
+  AlignedBuffer(const AlignedBuffer& b) = delete;
+  AlignedBuffer& operator=(const AlignedBuffer& b) = delete;
+
+  AlignedBuffer(AlignedBuffer&& b);
+  AlignedBuffer& operator=(AlignedBuffer&& b);
+
+  uint8_t* data() { return data_; }
+
+  const uint8_t* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+  // Returns the index of the buffer in the reactors registered buffers, or -1
+  // if the buffer isn't registered.
+  int index() const { return index_; }
+
+ private:
+  // Required to set index_.
+  friend void RegisterBuffers(const std::vector<AlignedBuffer*>& buffers);
+  friend void UnregisterBuffers(const std::vector<AlignedBuffer*>& buffers);
+
+  uint8_t* data_ = nullptr;
+
+  size_t size_ = 0;
+
+  int index_ = -1;
+};
+
+// Registers the buffers with the local reactor, so file reads and writes
+// using the buffers avoid the kernel mapping the buffers pages for each
+// operation.
+//
+// Only one set of buffers can be registered with a reactor at a time, and
+// the buffers must not be destroyed until they are unregistered.
+void RegisterBuffers(const std::vector<AlignedBuffer*>& buffers);
+
+// Unregisters buffers registered with RegisterBuffers.
+void UnregisterBuffers(const std::vector<AlignedBuffer*>& buffers);
+
+}  // namespace fs
+}  // namespace puddle
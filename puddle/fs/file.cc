@@ -0,0 +1,139 @@
+#include "puddle/fs/file.h"
+
+#include <unistd.h>
+
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+#include "puddle/internal/reactor.h"
+
+namespace puddle {
+namespace fs {
+
+namespace {
+
+// io_uring takes the size of reads and writes as an unsigned.
+void CheckSize(size_t size) {
+  if (size > std::numeric_limits<unsigned>::max()) {
+    throw std::invalid_argument{"file: size exceeds maximum operation size"};
+  }
+}
+
+// Checks the operation fits in the buffer.
+void CheckSize(const AlignedBuffer& buf, size_t size) {
+  if (size > buf.size()) {
+    throw std::invalid_argument{"file: size exceeds buffer size"};
+  }
+  CheckSize(size);
+}
+
+}  // namespace
+
+File::~File() {
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
+
+File::File(File&& f) {
+  fd_ = f.fd_;
+  f.fd_ = -1;
+}
+
+File& File::operator=(File&& f) {
+  std::swap(fd_, f.fd_);
+  return *this;
+}
+
+size_t File::ReadAt(uint8_t* buf, size_t size, off_t offset) {
+  CheckSize(size);
+  internal::IoRequest io;
+  internal::BlockingRequest r{&io};
+  r.Read(fd_, buf, size, offset);
+  int read_n = r.Wait();
+  if (read_n < 0) {
+    throw std::system_error(-read_n, std::system_category(), "file read");
+  }
+  return read_n;
+}
+
+size_t File::ReadAt(AlignedBuffer& buf, size_t size, off_t offset) {
+  CheckSize(buf, size);
+  if (buf.index() == -1) {
+    return ReadAt(buf.data(), size, offset);
+  }
+
+  internal::IoRequest io;
+  internal::BlockingRequest r{&io};
+  r.ReadFixed(fd_, buf.data(), size, offset, buf.index());
+  int read_n = r.Wait();
+  if (read_n < 0) {
+    throw std::system_error(-read_n, std::system_category(), "file read");
+  }
+  return read_n;
+}
+
+size_t File::WriteAt(const uint8_t* buf, size_t size, off_t offset) {
+  CheckSize(size);
+  internal::IoRequest io;
+  internal::BlockingRequest r{&io};
+  r.Write(fd_, buf, size, offset);
+  int write_n = r.Wait();
+  if (write_n < 0) {
+    throw std::system_error(-write_n, std::system_category(), "file write");
+  }
+  return write_n;
+}
+
+size_t File::WriteAt(const AlignedBuffer& buf, size_t size, off_t offset) {
+  CheckSize(buf, size);
+  if (buf.index() == -1) {
+    return WriteAt(buf.data(), size, offset);
+  }
+
+  internal::IoRequest io;
+  internal::BlockingRequest r{&io};
+  r.WriteFixed(fd_, buf.data(), size, offset, buf.index());
+  int write_n = r.Wait();
+  if (write_n < 0) {
+    throw std::system_error(-write_n, std::system_category(), "file write");
+  }
+  return write_n;
+}
+
+void File::Fsync() {
+  internal::IoRequest io;
+  internal::BlockingRequest r{&io};
+  r.Fsync(fd_, 0);
+  int res = r.Wait();
+  if (res < 0) {
+    throw std::system_error(-res, std::system_category(), "file sync");
+  }
+}
+
+void File::Fdatasync() {
+  internal::IoRequest io;
+  internal::BlockingRequest r{&io};
+  r.Fsync(fd_, IORING_FSYNC_DATASYNC);
+  int res = r.Wait();
+  if (res < 0) {
+    throw std::system_error(-res, std::system_category(), "file sync");
+  }
+}
+
+File File::Open(const std::string& path, int flags, mode_t mode) {
+  internal::IoRequest io;
+  internal::BlockingRequest r{&io};
+  r.OpenAt(AT_FDCWD, path.c_str(), flags | O_CLOEXEC, mode);
+  int fd = r.Wait();
+  if (fd < 0) {
+    throw std::system_error(-fd, std::system_category(), "file open: " + path);
+  }
+  return File{fd};
+}
+
+File::File(int fd) : fd_{fd} {}
+
+}  // namespace fs
+}  // namespace puddle
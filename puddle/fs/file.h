@@ -0,0 +1,72 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/types.h>
+
+#include <cstdint>
+#include <string>
+
+#include "puddle/fs/buffer.h"
+
+namespace puddle {
+namespace fs {
+
+// File is a file whose operations are submitted to the reactor (io_uring),
+// so block the calling task rather than the thread. Operations are queued by
+// the reactors IoScheduler, which shares the disk between task priorities.
+//
+// Files opened with O_DIRECT bypass the page cache, which requires buffers,
+// sizes and offsets to be aligned to the devices logical block size (see
+// AlignedBuffer).
+class File {
+ public:
+  File() = default;
+
+  ~File();
+
+  File(const File& f) = delete;
+  File& operator=(const File& f) = delete;
+
+  File(File&& f);
+  File& operator=(File&& f);
+
+  int fd() const { return fd_; }
+
+  // Reads up to size bytes at the given offset, returning the number of
+  // bytes read, which is only less than size if the end of the file is
+  // reached.
+  size_t ReadAt(uint8_t* buf, size_t size, off_t offset);
+
+  // Reads up to size bytes into the buffer at the given offset. If the
+  // buffer is registered, reads using the registered buffer. Throws
+  // std::invalid_argument if size exceeds the buffer size.
+  size_t ReadAt(AlignedBuffer& buf, size_t size, off_t offset);
+
+  // Writes up to size bytes at the given offset, returning the number of
+  // bytes written.
+  size_t WriteAt(const uint8_t* buf, size_t size, off_t offset);
+
+  // Writes up to size bytes from the buffer at the given offset. If the
+  // buffer is registered, writes using the registered buffer. Throws
+  // std::invalid_argument if size exceeds the buffer size.
+  size_t WriteAt(const AlignedBuffer& buf, size_t size, off_t offset);
+
+  // Flushes the files data and metadata to the device.
+  void Fsync();
+
+  // Flushes the files data to the device, along with only the metadata
+  // required to read the data (such as the file size).
+  void Fdatasync();
+
+  // Opens the file at path with the given open(2) flags (such as
+  // O_RDWR | O_CREAT | O_DIRECT) and mode.
+  static File Open(const std::string& path, int flags, mode_t mode = 0644);
+
+ private:
+  File(int fd);
+
+  int fd_ = -1;
+};
+
+}  // namespace fs
+}  // namespace puddle
@@ -0,0 +1,129 @@
+#include "puddle/fs/wal.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+namespace puddle {
+namespace fs {
+
+void Wal::CommitCompletion::Complete(int result, uint32_t flags) {
+  internal::Reactor::local()->io_scheduler()->Complete(
+      sync_ ? &wal_->sync_io_ : &wal_->write_io_);
+  if (sync_) {
+    wal_->CompleteSync(result);
+  } else {
+    wal_->CompleteWrite(result);
+  }
+}
+
+Wal::Wal(File file)
+    : file_{std::move(file)},
+      next_commit_{1},
+      durable_commit_{0},
+      in_progress_{false},
+      write_result_{0},
+      error_{0},
+      commits_{0},
+      write_completion_{this, false},
+      sync_completion_{this, true},
+      pending_priority_{internal::Priority::kBackground} {
+  off_t end = lseek(file_.fd(), 0, SEEK_END);
+  if (end == -1) {
+    throw std::system_error(errno, std::system_category(), "wal seek");
+  }
+  offset_ = end;
+  tail_ = end;
+}
+
+Wal::~Wal() {
+  while (in_progress_) {
+    commit_queue_.SuspendAndWait(internal::Reactor::local()->active());
+  }
+}
+
+uint64_t Wal::Append(const uint8_t* buf, size_t size) {
+  if (error_ != 0) {
+    throw std::system_error(error_, std::system_category(), "wal commit");
+  }
+
+  uint64_t offset = tail_;
+  tail_ += size;
+  pending_.insert(pending_.end(), buf, buf + size);
+  pending_priority_ = std::min(
+      pending_priority_, internal::Reactor::local()->active()->priority());
+
+  uint64_t commit = next_commit_;
+  if (!in_progress_) {
+    Commit();
+  }
+
+  // Wait for the commit containing the record to be durable. As the queue
+  // is notified whenever any commit completes, we may have to wait for
+  // multiple commits.
+  while (durable_commit_ < commit && error_ == 0) {
+    commit_queue_.SuspendAndWait(internal::Reactor::local()->active());
+  }
+  if (error_ != 0) {
+    throw std::system_error(error_, std::system_category(), "wal commit");
+  }
+  return offset;
+}
+
+void Wal::Commit() {
+  in_progress_ = true;
+  committing_.swap(pending_);
+  pending_.clear();
+  next_commit_++;
+
+  // Link the sync to the write so the sync only starts once the write
+  // completes, and the sync is cancelled if the write fails. The scheduler
+  // dispatches the linked pair together.
+  struct io_uring_sqe* write_sqe = &write_io_.sqe;
+  memset(write_sqe, 0, sizeof(*write_sqe));
+  io_uring_prep_write(write_sqe, file_.fd(), committing_.data(),
+                      committing_.size(), offset_);
+  io_uring_sqe_set_flags(write_sqe, IOSQE_IO_LINK);
+  write_io_.completion = &write_completion_;
+  write_io_.bytes = committing_.size();
+  write_io_.priority = pending_priority_;
+  write_io_.link = &sync_io_;
+
+  struct io_uring_sqe* sync_sqe = &sync_io_.sqe;
+  memset(sync_sqe, 0, sizeof(*sync_sqe));
+  io_uring_prep_fsync(sync_sqe, file_.fd(), IORING_FSYNC_DATASYNC);
+  sync_io_.completion = &sync_completion_;
+
+  pending_priority_ = internal::Priority::kBackground;
+  internal::Reactor::local()->io_scheduler()->Submit(&write_io_);
+}
+
+void Wal::CompleteWrite(int result) { write_result_ = result; }
+
+void Wal::CompleteSync(int result) {
+  if (write_result_ < 0) {
+    error_ = -write_result_;
+  } else if (static_cast<size_t>(write_result_) != committing_.size()) {
+    // A short write breaks the link so the sync is cancelled.
+    error_ = EIO;
+  } else if (result < 0) {
+    error_ = -result;
+  } else {
+    offset_ += committing_.size();
+    durable_commit_ = next_commit_ - 1;
+    commits_++;
+  }
+
+  in_progress_ = false;
+  commit_queue_.NotifyAll();
+
+  // Commit any records appended while the commit was in progress.
+  if (error_ == 0 && !pending_.empty()) {
+    Commit();
+  }
+}
+
+}  // namespace fs
+}  // namespace puddle
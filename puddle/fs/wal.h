@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "puddle/fs/file.h"
+#include "puddle/internal/reactor.h"
+#include "puddle/internal/sync.h"
+
+namespace puddle {
+namespace fs {
+
+// Wal is an append-only write-ahead log.
+//
+// Appends from concurrent tasks are group committed: records appended while a
+// commit is in progress are buffered, then written by the next commit with a
+// single write followed by a linked fdatasync. Each appending task blocks
+// until the commit containing its record is durable.
+//
+// Commits are queued by the reactors IoScheduler with the highest priority of
+// the tasks whose records they contain.
+//
+// If a commit fails, the state of the log file is unknown, so the log fails
+// all pending and future appends.
+class Wal {
+ public:
+  // Appends to the given file, starting at the end of the file.
+  Wal(File file);
+
+  // Waits for any in-progress commit to complete.
+  ~Wal();
+
+  Wal(const Wal& w) = delete;
+  Wal& operator=(const Wal& w) = delete;
+
+  Wal(Wal&& w) = delete;
+  Wal& operator=(Wal&& w) = delete;
+
+  // Appends the record to the log and blocks until it is durable. Returns the
+  // offset of the record in the log file.
+  uint64_t Append(const uint8_t* buf, size_t size);
+
+  // Returns the number of commits.
+  uint64_t commits() const { return commits_; }
+
+ private:
+  // Completes the commit write or sync.
+  class CommitCompletion final : public internal::Completion {
+   public:
+    CommitCompletion(Wal* wal, bool sync) : wal_{wal}, sync_{sync} {}
+
+    void Complete(int result, uint32_t flags) override;
+
+   private:
+    Wal* wal_;
+
+    bool sync_;
+  };
+
+  // Submits a write of the pending records, linked with a sync.
+  void Commit();
+
+  void CompleteWrite(int result);
+
+  void CompleteSync(int result);
+
+  File file_;
+
+  // Records that have been appended but not yet committed.
+  std::vector<uint8_t> pending_;
+
+  // Records being committed. This is separate to pending_ so appends can
+  // continue while a commit is in progress.
+  std::vector<uint8_t> committing_;
+
+  // Offset in the file to write the next commit.
+  uint64_t offset_;
+
+  // Offset of the next appended record.
+  uint64_t tail_;
+
+  // Sequence number of the commit the next appended record will be included
+  // in.
+  uint64_t next_commit_;
+
+  // Sequence number of the last durable commit.
+  uint64_t durable_commit_;
+
+  // Whether a commit is in progress.
+  bool in_progress_;
+
+  // Result of the in-progress commits write.
+  int write_result_;
+
+  // Error (errno) from a failed commit, or 0 if there is no error.
+  int error_;
+
+  uint64_t commits_;
+
+  CommitCompletion write_completion_;
+
+  CommitCompletion sync_completion_;
+
+  // Commit write and sync operations queued by the IoScheduler, where the
+  // write links to the sync.
+  internal::IoRequest write_io_;
+
+  internal::IoRequest sync_io_;
+
+  // Highest priority of the tasks that appended the pending records.
+  internal::Priority pending_priority_;
+
+  // Queue of contexts waiting for a commit to complete.
+  internal::WaitQueue commit_queue_;
+};
+
+}  // namespace fs
+}  // namespace puddle
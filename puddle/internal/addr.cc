@@ -0,0 +1,126 @@
+#include "puddle/internal/addr.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/un.h>
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace puddle {
+namespace internal {
+
+SocketAddr ParseAddr(const std::string& addr) {
+  SocketAddr sock_addr;
+  memset(&sock_addr, 0, sizeof(sock_addr));
+
+  // Split on the last ':' as IPv6 addresses contain ':'.
+  size_t pos = addr.rfind(':');
+  if (pos == std::string::npos) {
+    throw std::runtime_error("invalid address: " + addr);
+  }
+
+  std::string ip_str = addr.substr(0, pos);
+  std::string port_str = addr.substr(pos + 1);
+
+  uint16_t port;
+  try {
+    int p = std::stoi(port_str);
+    if (p < 1 || p > 65535) {
+      throw std::runtime_error("invalid address: " + addr);
+    }
+    port = htons(p);
+  } catch (const std::exception& e) {
+    throw std::runtime_error("invalid address: " + addr);
+  }
+
+  if (ip_str.size() >= 2 && ip_str.front() == '[' && ip_str.back() == ']') {
+    // IPv6 addresses are enclosed in brackets.
+    struct sockaddr_in6* in6_addr =
+        reinterpret_cast<struct sockaddr_in6*>(&sock_addr.storage);
+    in6_addr->sin6_family = AF_INET6;
+    in6_addr->sin6_port = port;
+    sock_addr.len = sizeof(struct sockaddr_in6);
+
+    std::string ip6_str = ip_str.substr(1, ip_str.size() - 2);
+    if (inet_pton(AF_INET6, ip6_str.c_str(), &in6_addr->sin6_addr) != 1) {
+      throw std::runtime_error("invalid address: " + addr);
+    }
+    return sock_addr;
+  }
+
+  struct sockaddr_in* in_addr =
+      reinterpret_cast<struct sockaddr_in*>(&sock_addr.storage);
+  in_addr->sin_family = AF_INET;
+  in_addr->sin_port = port;
+  sock_addr.len = sizeof(struct sockaddr_in);
+
+  if (ip_str == "") {
+    in_addr->sin_addr.s_addr = INADDR_ANY;
+  } else {
+    if (inet_pton(AF_INET, ip_str.c_str(), &in_addr->sin_addr) != 1) {
+      throw std::runtime_error("invalid address: " + addr);
+    }
+  }
+
+  return sock_addr;
+}
+
+SocketAddr ParseUnixAddr(const std::string& path) {
+  SocketAddr sock_addr;
+  memset(&sock_addr, 0, sizeof(sock_addr));
+
+  struct sockaddr_un* un_addr =
+      reinterpret_cast<struct sockaddr_un*>(&sock_addr.storage);
+  un_addr->sun_family = AF_UNIX;
+
+  // The path must fit in sun_path including the null terminator.
+  if (path.empty() || path.size() >= sizeof(un_addr->sun_path)) {
+    throw std::runtime_error("invalid address: " + path);
+  }
+
+  if (path[0] == '@') {
+    // Abstract namespace addresses start with a null byte and aren't null
+    // terminated, so the length excludes the terminator.
+    memcpy(un_addr->sun_path + 1, path.data() + 1, path.size() - 1);
+    sock_addr.len = offsetof(struct sockaddr_un, sun_path) + path.size();
+  } else {
+    memcpy(un_addr->sun_path, path.data(), path.size());
+    sock_addr.len = offsetof(struct sockaddr_un, sun_path) + path.size() + 1;
+  }
+
+  return sock_addr;
+}
+
+std::string FormatAddr(const SocketAddr& addr) {
+  if (addr.family() == AF_UNIX) {
+    const struct sockaddr_un* un_addr =
+        reinterpret_cast<const struct sockaddr_un*>(&addr.storage);
+    size_t len = addr.len - offsetof(struct sockaddr_un, sun_path);
+    if (len > 0 && un_addr->sun_path[0] == '\0') {
+      return "@" + std::string{un_addr->sun_path + 1, len - 1};
+    }
+    return std::string{un_addr->sun_path, strnlen(un_addr->sun_path, len)};
+  }
+  if (addr.family() == AF_INET6) {
+    const struct sockaddr_in6* in6_addr =
+        reinterpret_cast<const struct sockaddr_in6*>(&addr.storage);
+    char ip[INET6_ADDRSTRLEN];
+    inet_ntop(AF_INET6, &in6_addr->sin6_addr, ip, sizeof(ip));
+    return "[" + std::string{ip} +
+           "]:" + std::to_string(ntohs(in6_addr->sin6_port));
+  }
+  if (addr.family() != AF_INET) {
+    return "unknown";
+  }
+
+  const struct sockaddr_in* in_addr =
+      reinterpret_cast<const struct sockaddr_in*>(&addr.storage);
+  char ip[INET_ADDRSTRLEN];
+  inet_ntop(AF_INET, &in_addr->sin_addr, ip, sizeof(ip));
+  return std::string{ip} + ":" + std::to_string(ntohs(in_addr->sin_port));
+}
+
+}  // namespace internal
+}  // namespace puddle
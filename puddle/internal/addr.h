@@ -0,0 +1,42 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <string>
+
+namespace puddle {
+namespace internal {
+
+// SocketAddr is a socket address of any family.
+struct SocketAddr {
+  struct sockaddr_storage storage;
+
+  socklen_t len;
+
+  struct sockaddr* addr() {
+    return reinterpret_cast<struct sockaddr*>(&storage);
+  }
+
+  const struct sockaddr* addr() const {
+    return reinterpret_cast<const struct sockaddr*>(&storage);
+  }
+
+  int family() const { return storage.ss_family; }
+};
+
+// Parses an address of the form ip:port, where IPv6 addresses are enclosed
+// in brackets (such as [::1]:4411). If the ip is empty, uses the IPv4
+// INADDR_ANY. Use [::]:port to bind to all IPv4 and IPv6 addresses
+// (dual-stack).
+SocketAddr ParseAddr(const std::string& addr);
+
+// Parses a Unix domain socket address, which is either a file system path, or
+// a name in the abstract namespace if prefixed with '@'.
+SocketAddr ParseUnixAddr(const std::string& path);
+
+// Formats the address as ip:port (with IPv6 addresses enclosed in brackets),
+// or the path for Unix domain sockets.
+std::string FormatAddr(const SocketAddr& addr);
+
+}  // namespace internal
+}  // namespace puddle
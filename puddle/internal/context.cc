@@ -5,7 +5,11 @@
 namespace puddle {
 namespace internal {
 
-Context::Context() : ref_count_{1} {}
+Context::Context()
+    : terminated_{false},
+      name_{"task"},
+      priority_{Priority::kNormal},
+      ref_count_{1} {}
 
 Context::~Context() {
   assert(!ready_hook_.is_linked());
@@ -22,6 +26,27 @@ void Context::Suspend() { Reactor::local()->Suspend(); }
 
 void Context::Schedule() { Reactor::local()->Schedule(this); }
 
+void Context::AddSuspendHook(SuspendHook* hook) {
+  if (hook->is_registered()) return;
+  suspend_hooks_.push_back(*hook);
+}
+
+void Context::RunSuspendHooks() {
+  while (!suspend_hooks_.empty()) {
+    SuspendHook* hook = &suspend_hooks_.front();
+    suspend_hooks_.pop_front();
+    hook->OnSuspend();
+  }
+}
+
+void Context::set_name(const char* name) {
+  name_ = name;
+#ifdef PUDDLE_TASK_TRACING
+  // Look up the stats for the new name when next traced.
+  trace_stats_ = nullptr;
+#endif
+}
+
 boost::context::fiber Context::Terminate() {
   terminated_ = true;
   join_queue_.NotifyAll();
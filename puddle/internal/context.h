@@ -13,6 +13,8 @@ namespace internal {
 
 class Reactor;
 class Scheduler;
+class TaskStats;
+class TaskTracer;
 
 using ReadyHook = boost::intrusive::list_member_hook<
     boost::intrusive::link_mode<boost::intrusive::safe_link>>;
@@ -23,6 +25,48 @@ using SleepHook = boost::intrusive::set_member_hook<
 using TerminateHook = boost::intrusive::list_member_hook<
     boost::intrusive::link_mode<boost::intrusive::safe_link>>;
 
+// Uses auto_unlink so a hook is removed from its context when destroyed.
+using SuspendHookHook = boost::intrusive::list_member_hook<
+    boost::intrusive::link_mode<boost::intrusive::auto_unlink>>;
+
+// SuspendHook is notified before the context it is registered with is
+// switched out (either yielding or suspending).
+//
+// Hooks are one shot, so are removed from the context before being notified
+// and must be re-registered to be notified again.
+class SuspendHook {
+ public:
+  virtual void OnSuspend() = 0;
+
+  bool is_registered() const { return hook_.is_linked(); }
+
+ protected:
+  ~SuspendHook() = default;
+
+  // Removes the hook from the context it's registered with, if any.
+  void Unregister() { hook_.unlink(); }
+
+ private:
+  // Required to access the intrusive member hook.
+  friend Context;
+
+  SuspendHookHook hook_;
+};
+
+// Priority class of a task, which the scheduler uses to pick the next ready
+// task (see Scheduler).
+enum class Priority : uint8_t {
+  // Latency sensitive tasks, such as serving requests, which always run
+  // before normal and background tasks.
+  kLatency,
+  kNormal,
+  // Background tasks, such as compaction, which are limited to a share of
+  // the reactor when normal tasks are also ready.
+  kBackground,
+};
+
+constexpr size_t kPriorities = 3;
+
 // Context represents the a tasks execution state.
 class Context {
  public:
@@ -43,6 +87,27 @@ class Context {
   // Schedule adds the context to the ready queue.
   void Schedule();
 
+  // Registers the hook to be notified before the context is next switched
+  // out. Has no effect if the hook is already registered.
+  void AddSuspendHook(SuspendHook* hook);
+
+  // Notifies and removes all registered suspend hooks.
+  void RunSuspendHooks();
+
+  // Returns the contexts name, which identifies the task in traces and
+  // diagnostics. Defaults to "task".
+  const char* name() const { return name_; }
+
+  // Sets the contexts name. name must outlive the context, such as a string
+  // literal.
+  void set_name(const char* name);
+
+  Priority priority() const { return priority_; }
+
+  // Sets the contexts priority, which applies the next time the context is
+  // added to the ready queue.
+  void set_priority(Priority priority) { priority_ = priority; }
+
   friend void intrusive_ptr_add_ref(Context* c) noexcept;
   friend void intrusive_ptr_release(Context* c) noexcept;
 
@@ -61,12 +126,24 @@ class Context {
   // Required to access intrusive member hooks.
   friend Scheduler;
 
+  // Required to access the trace state.
+  friend TaskTracer;
+
   ReadyHook ready_hook_;
 
   SleepHook sleep_hook_;
 
   TerminateHook terminated_hook_;
 
+  using SuspendHookList = boost::intrusive::list<
+      SuspendHook,
+      boost::intrusive::member_hook<SuspendHook, SuspendHookHook,
+                                    &SuspendHook::hook_>,
+      boost::intrusive::constant_time_size<false>>;
+
+  // Hooks to notify before the context is next switched out.
+  SuspendHookList suspend_hooks_;
+
   // Time the context is asleep till when it is in the schedulers sleep queue.
   std::chrono::steady_clock::time_point sleep_tp_;
 
@@ -75,6 +152,21 @@ class Context {
 
   bool terminated_;
 
+  const char* name_;
+
+  Priority priority_;
+
+#ifdef PUDDLE_TASK_TRACING
+  // Cached stats for the contexts name, owned by the reactors tracer.
+  TaskStats* trace_stats_ = nullptr;
+
+  // Time the context was added to the ready queue, or zero if it isn't ready.
+  std::chrono::steady_clock::time_point ready_tp_;
+
+  // Time the context was last resumed.
+  std::chrono::steady_clock::time_point run_tp_;
+#endif
+
   // Reference counter for intrusive_ptr.
   size_t ref_count_;
 };
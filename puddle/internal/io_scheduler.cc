@@ -0,0 +1,145 @@
+#include "puddle/internal/io_scheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "puddle/internal/reactor.h"
+
+namespace puddle {
+namespace internal {
+
+namespace {
+
+// Fixed cost of each operation in bytes, so operations that transfer few
+// bytes (such as fsync) still consume their class's share.
+constexpr uint64_t kOpCost = 4096;
+
+}  // namespace
+
+IoScheduler::Config IoScheduler::Config::Default() {
+  Config config;
+  config.weights[static_cast<size_t>(Priority::kLatency)] = 16;
+  config.weights[static_cast<size_t>(Priority::kNormal)] = 4;
+  config.weights[static_cast<size_t>(Priority::kBackground)] = 1;
+  config.max_ops = 64;
+  config.max_bytes = 4 << 20;
+  config.latency_target = std::chrono::milliseconds{2};
+  return config;
+}
+
+IoScheduler::IoScheduler(Reactor* reactor, Config config)
+    : reactor_{reactor}, config_{config} {
+  if (config_.max_ops == 0) {
+    throw std::invalid_argument{"io scheduler: max_ops must be positive"};
+  }
+  for (size_t i = 0; i != kPriorities; i++) {
+    if (config_.weights[i] == 0) {
+      throw std::invalid_argument{"io scheduler: weights must be positive"};
+    }
+    classes_[i].max_ops = config_.max_ops;
+  }
+}
+
+void IoScheduler::Submit(IoRequest* request) {
+  auto now = std::chrono::steady_clock::now();
+  for (IoRequest* r = request; r != nullptr; r = r->link) {
+    r->priority = request->priority;
+    r->queued = now;
+  }
+  classes_[static_cast<size_t>(request->priority)].queue.push_back(*request);
+  queued_++;
+  Dispatch();
+}
+
+void IoScheduler::Complete(IoRequest* request) {
+  Class& c = classes_[static_cast<size_t>(request->priority)];
+  c.ops--;
+  ops_--;
+  bytes_ -= request->bytes;
+
+  auto now = std::chrono::steady_clock::now();
+  OnLatency(request->priority, now, now - request->queued);
+
+  Dispatch();
+}
+
+void IoScheduler::Dispatch() {
+  while (queued_ > 0 && ops_ < config_.max_ops) {
+    // Pick the class whose next request has the earliest virtual start time,
+    // skipping classes at their limit. Ties go to the higher priority class.
+    size_t next = kPriorities;
+    uint64_t next_start = 0;
+    for (size_t i = 0; i != kPriorities; i++) {
+      const Class& c = classes_[i];
+      if (c.queue.empty() || c.ops >= c.max_ops) {
+        continue;
+      }
+      uint64_t start = Start(c);
+      if (next == kPriorities || start < next_start) {
+        next = i;
+        next_start = start;
+      }
+    }
+    if (next == kPriorities) {
+      return;
+    }
+
+    Class& c = classes_[next];
+    IoRequest& request = c.queue.front();
+    uint32_t ops = 0;
+    uint64_t bytes = 0;
+    for (IoRequest* r = &request; r != nullptr; r = r->link) {
+      ops++;
+      bytes += r->bytes;
+    }
+    if (ops_ > 0 && bytes_ + bytes > config_.max_bytes) {
+      // Wait for in-flight requests to complete rather than dispatching
+      // another class out of order.
+      return;
+    }
+    c.queue.pop_front();
+    queued_--;
+
+    c.finish = next_start + (bytes + ops * kOpCost) / config_.weights[next];
+    vtime_ = next_start;
+    c.ops += ops;
+    ops_ += ops;
+    bytes_ += bytes;
+
+    // Reserve space for the whole chain, as linked entries must be
+    // submitted together.
+    struct io_uring_sqe* sqe = reactor_->GetSqe(request.completion, ops);
+    for (IoRequest* r = &request; r != nullptr; r = r->link) {
+      if (r != &request) {
+        sqe = reactor_->GetSqe(r->completion);
+      }
+      *sqe = r->sqe;
+      io_uring_sqe_set_data(sqe, r->completion);
+    }
+  }
+}
+
+uint64_t IoScheduler::Start(const Class& c) const {
+  return std::max(c.finish, vtime_);
+}
+
+void IoScheduler::OnLatency(Priority priority,
+                            std::chrono::steady_clock::time_point now,
+                            std::chrono::steady_clock::duration latency) {
+  Class& background = classes_[static_cast<size_t>(Priority::kBackground)];
+  if (priority != Priority::kBackground && latency > config_.latency_target) {
+    // Halve at most once per target, so a burst of slow completions caused
+    // by the same backlog doesn't collapse the limit.
+    if (now - last_decrease_ >= config_.latency_target) {
+      background.max_ops = std::max<uint32_t>(background.max_ops / 2, 1);
+      last_decrease_ = now;
+    }
+    return;
+  }
+  if (background.max_ops < config_.max_ops) {
+    background.max_ops++;
+  }
+}
+
+}  // namespace internal
+}  // namespace puddle
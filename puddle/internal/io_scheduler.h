@@ -0,0 +1,160 @@
+#pragma once
+
+#include <liburing.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "boost/intrusive/list.hpp"
+#include "puddle/internal/context.h"
+
+namespace puddle {
+namespace internal {
+
+class Completion;
+class Reactor;
+
+using IoQueueHook = boost::intrusive::list_member_hook<
+    boost::intrusive::link_mode<boost::intrusive::safe_link>>;
+
+// IoRequest is an operation dispatched by the IoScheduler.
+struct IoRequest {
+  // Prepared submission queue entry, copied to the submission queue when
+  // dispatched.
+  struct io_uring_sqe sqe;
+
+  // Completion the operation's result is passed to.
+  Completion* completion = nullptr;
+
+  // Number of bytes the operation reads or writes.
+  uint64_t bytes = 0;
+
+  Priority priority = Priority::kNormal;
+
+  // Next request in a chain linked with IOSQE_IO_LINK, which is dispatched
+  // together with this request, or nullptr.
+  IoRequest* link = nullptr;
+
+  // Time the operation was queued.
+  std::chrono::steady_clock::time_point queued;
+
+  IoQueueHook hook;
+};
+
+// IoScheduler isolates disk I/O between task priority classes.
+//
+// Rather than submitting operations to io_uring as soon as tasks request
+// them, operations are queued by the priority of the requesting task (see
+// Priority), and dispatched while the number of operations and bytes in
+// flight are within limits. Classes with queued operations share the disk by
+// start-time fair queueing, weighted by Config::weights, where an operation's
+// cost is its size plus a fixed per operation cost.
+//
+// So a background task issuing thousands of large reads only delays a
+// latency task's read by the operations already in flight, rather than every
+// operation queued ahead of it. To bound that delay, the limit of background
+// operations in flight adapts to the latency of latency and normal
+// operations: it is halved (at most once per latency target) when their
+// latency exceeds the target, and grows by one on each other completion.
+//
+// Only disk operations are scheduled, such as by fs::File and fs::Wal.
+// Network operations may be in flight indefinitely, such as a write to a slow
+// peer, so would hold the in-flight limits.
+class IoScheduler {
+ public:
+  struct Config {
+    // Relative share of the disk given to each priority class when multiple
+    // classes have queued operations, indexed by Priority.
+    uint32_t weights[kPriorities];
+
+    // Maximum number of operations in flight.
+    uint32_t max_ops;
+
+    // Maximum number of bytes in flight. An operation larger than the limit
+    // is dispatched once no other operations are in flight.
+    uint64_t max_bytes;
+
+    // Target latency (from queueing an operation to its completion) of latency
+    // and normal operations.
+    std::chrono::microseconds latency_target;
+
+    static Config Default();
+  };
+
+  IoScheduler(Reactor* reactor, Config config);
+
+  IoScheduler(const IoScheduler& s) = delete;
+  IoScheduler& operator=(const IoScheduler& s) = delete;
+
+  IoScheduler(IoScheduler&& s) = delete;
+  IoScheduler& operator=(IoScheduler&& s) = delete;
+
+  // Queues the prepared request, which is dispatched immediately if within
+  // the limits. If the request links to other requests, the chain is
+  // dispatched as one unit with the requests priority, which may exceed the
+  // operation limits by the length of the chain.
+  void Submit(IoRequest* request);
+
+  // Releases the capacity of the completed request, then dispatches queued
+  // requests. Must be called for each request in a chain before the request
+  // is destroyed.
+  void Complete(IoRequest* request);
+
+  // Returns the number of queued requests (or chains) that haven't been
+  // dispatched.
+  size_t queued() const { return queued_; }
+
+  // Returns the number of dispatched requests that haven't completed.
+  size_t in_flight() const { return ops_; }
+
+ private:
+  using IoQueue = boost::intrusive::list<
+      IoRequest,
+      boost::intrusive::member_hook<IoRequest, IoQueueHook, &IoRequest::hook>>;
+
+  struct Class {
+    IoQueue queue;
+
+    // Virtual finish time of the last request dispatched from the class.
+    uint64_t finish = 0;
+
+    uint32_t ops = 0;
+
+    // Maximum number of requests in flight, which only adapts for
+    // background.
+    uint32_t max_ops = 0;
+  };
+
+  // Dispatches queued requests while within the limits.
+  void Dispatch();
+
+  // Returns the virtual start time of the class's next request.
+  uint64_t Start(const Class& c) const;
+
+  // Adapts the background limit to the latency of a completed request.
+  void OnLatency(Priority priority, std::chrono::steady_clock::time_point now,
+                 std::chrono::steady_clock::duration latency);
+
+  Reactor* reactor_;
+
+  Config config_;
+
+  Class classes_[kPriorities];
+
+  // Virtual time, which is the start time of the last dispatched request.
+  // Classes that were idle restart from the virtual time so don't accumulate
+  // credit.
+  uint64_t vtime_ = 0;
+
+  uint32_t ops_ = 0;
+
+  uint64_t bytes_ = 0;
+
+  size_t queued_ = 0;
+
+  // Time the background limit was last halved.
+  std::chrono::steady_clock::time_point last_decrease_;
+};
+
+}  // namespace internal
+}  // namespace puddle
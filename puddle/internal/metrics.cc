@@ -0,0 +1,73 @@
+#include "puddle/internal/metrics.h"
+
+#include <string>
+
+#include "puddle/stats/registry.h"
+
+namespace puddle {
+namespace internal {
+
+ReactorMetrics::ReactorMetrics(int reactor_id) {
+  stats::Registry* r = stats::Registry::global();
+  stats::Labels labels{{"reactor", std::to_string(reactor_id)}};
+
+  r->Register("puddle_reactor_loop_iterations_total",
+              "Number of reactor event loop iterations.", labels,
+              &loop_iterations);
+  r->Register("puddle_reactor_sqes_submitted_total",
+              "Number of io_uring submission queue entries submitted.",
+              labels, &sqes_submitted);
+  r->Register("puddle_reactor_sqes_per_submit",
+              "Number of submission queue entries per io_uring submit.",
+              labels, &sqes_per_submit);
+  r->Register("puddle_reactor_cqes_dispatched_total",
+              "Number of io_uring completion queue entries dispatched.",
+              labels, &cqes_dispatched);
+  r->Register("puddle_reactor_cqes_per_dispatch",
+              "Number of completion queue entries per dispatch.", labels,
+              &cqes_per_dispatch);
+  r->Register("puddle_reactor_wait_nanoseconds_total",
+              "Time blocked waiting for io_uring completions.", labels,
+              &wait_ns);
+  r->Register("puddle_reactor_ready_tasks",
+              "Number of tasks in the ready queue.", labels, &ready_tasks);
+  r->Register("puddle_reactor_sleeping_tasks",
+              "Number of tasks in the sleep queue.", labels, &sleeping_tasks);
+  r->Register("puddle_reactor_io_queued",
+              "Number of operations queued by the I/O scheduler.", labels,
+              &io_queued);
+  r->Register("puddle_reactor_io_in_flight",
+              "Number of operations dispatched by the I/O scheduler that "
+              "haven't completed.",
+              labels, &io_in_flight);
+  r->Register("puddle_reactor_live_tasks",
+              "Number of spawned tasks that haven't terminated.", labels,
+              &live_tasks);
+  r->Register("puddle_reactor_spawns_total", "Number of tasks spawned.",
+              labels, &spawns);
+  r->Register("puddle_reactor_terminations_total",
+              "Number of tasks terminated.", labels, &terminations);
+  r->Register("puddle_reactor_context_switches_total",
+              "Number of context switches.", labels, &context_switches);
+}
+
+ReactorMetrics::~ReactorMetrics() {
+  stats::Registry* r = stats::Registry::global();
+  r->Unregister(&loop_iterations);
+  r->Unregister(&sqes_submitted);
+  r->Unregister(&sqes_per_submit);
+  r->Unregister(&cqes_dispatched);
+  r->Unregister(&cqes_per_dispatch);
+  r->Unregister(&wait_ns);
+  r->Unregister(&ready_tasks);
+  r->Unregister(&sleeping_tasks);
+  r->Unregister(&io_queued);
+  r->Unregister(&io_in_flight);
+  r->Unregister(&live_tasks);
+  r->Unregister(&spawns);
+  r->Unregister(&terminations);
+  r->Unregister(&context_switches);
+}
+
+}  // namespace internal
+}  // namespace puddle
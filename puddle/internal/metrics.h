@@ -0,0 +1,71 @@
+#pragma once
+
+#include "puddle/stats/local_histogram.h"
+#include "puddle/stats/metrics.h"
+
+namespace puddle {
+namespace internal {
+
+// Runtime metrics recorded by a reactor.
+//
+// Metrics are only updated by the reactor thread so recording is a relaxed
+// load and store, cheap enough to leave enabled. The metrics are registered
+// with the global stats::Registry, labelled with the reactor ID, so they can
+// be read from other threads.
+class ReactorMetrics {
+ public:
+  explicit ReactorMetrics(int reactor_id);
+
+  ~ReactorMetrics();
+
+  ReactorMetrics(const ReactorMetrics& m) = delete;
+  ReactorMetrics& operator=(const ReactorMetrics& m) = delete;
+
+  ReactorMetrics(ReactorMetrics&& m) = delete;
+  ReactorMetrics& operator=(ReactorMetrics&& m) = delete;
+
+  // Number of event loop iterations.
+  stats::Counter loop_iterations;
+
+  // Number of SQEs submitted to io_uring.
+  stats::Counter sqes_submitted;
+
+  // Number of SQEs submitted per non-empty submit.
+  stats::LocalHistogram sqes_per_submit;
+
+  // Number of CQEs dispatched.
+  stats::Counter cqes_dispatched;
+
+  // Number of CQEs dispatched per non-empty dispatch.
+  stats::LocalHistogram cqes_per_dispatch;
+
+  // Time blocked waiting for completions in nanoseconds.
+  stats::Counter wait_ns;
+
+  // Number of contexts in the ready queue, updated once per loop iteration.
+  stats::Gauge ready_tasks;
+
+  // Number of contexts in the sleep queue, updated once per loop iteration.
+  stats::Gauge sleeping_tasks;
+
+  // Number of operations queued by the I/O scheduler, updated once per loop
+  // iteration.
+  stats::Gauge io_queued;
+
+  // Number of operations dispatched by the I/O scheduler that haven't
+  // completed, updated once per loop iteration.
+  stats::Gauge io_in_flight;
+
+  // Number of spawned tasks that haven't terminated.
+  stats::Gauge live_tasks;
+
+  stats::Counter spawns;
+
+  stats::Counter terminations;
+
+  // Number of switches between contexts (including the reactor context).
+  stats::Counter context_switches;
+};
+
+}  // namespace internal
+}  // namespace puddle
@@ -0,0 +1,89 @@
+#include "puddle/internal/pipe.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+
+#include "puddle/internal/reactor.h"
+
+namespace puddle {
+namespace internal {
+
+SplicePipe::SplicePipe(int read_fd, int write_fd)
+    : read_fd_{read_fd}, write_fd_{write_fd} {
+  if (write_fd_ != -1) {
+    // Attempt to increase the pipe capacity. This may fail if the capacity
+    // exceeds /proc/sys/fs/pipe-max-size, in which case we use the existing
+    // capacity.
+    fcntl(write_fd_, F_SETPIPE_SZ, kCapacity);
+    int capacity = fcntl(write_fd_, F_GETPIPE_SZ);
+    // If the capacity can't be read, assume the kernel default.
+    capacity_ = capacity > 0 ? capacity : kDefaultCapacity;
+  }
+}
+
+SplicePipe::~SplicePipe() {
+  if (read_fd_ != -1) {
+    close(read_fd_);
+  }
+  if (write_fd_ != -1) {
+    close(write_fd_);
+  }
+}
+
+SplicePipe::SplicePipe(SplicePipe&& p) {
+  std::swap(read_fd_, p.read_fd_);
+  std::swap(write_fd_, p.write_fd_);
+  std::swap(capacity_, p.capacity_);
+}
+
+SplicePipe& SplicePipe::operator=(SplicePipe&& p) {
+  std::swap(read_fd_, p.read_fd_);
+  std::swap(write_fd_, p.write_fd_);
+  std::swap(capacity_, p.capacity_);
+  return *this;
+}
+
+size_t SplicePipe::Splice(int fd_in, int64_t off_in, int fd_out, size_t size) {
+  size = std::min(size, capacity_);
+
+  // Splice from fd_in into the pipe.
+  BlockingRequest in_r;
+  in_r.Splice(fd_in, off_in, write_fd_, -1, size, SPLICE_F_MOVE);
+  int in_n = in_r.Wait();
+  if (in_n < 0) {
+    throw std::system_error(-in_n, std::system_category(), "splice");
+  }
+
+  // Drain the pipe into fd_out, which may require multiple splices.
+  int out_n = 0;
+  while (out_n < in_n) {
+    BlockingRequest out_r;
+    out_r.Splice(read_fd_, -1, fd_out, -1, in_n - out_n, SPLICE_F_MOVE);
+    int n = out_r.Wait();
+    if (n < 0) {
+      throw std::system_error(-n, std::system_category(), "splice");
+    }
+    if (n == 0) {
+      // fd_out accepts no more bytes, so retrying would splice forever.
+      throw std::system_error(EPIPE, std::system_category(), "splice");
+    }
+    out_n += n;
+  }
+
+  return in_n;
+}
+
+SplicePipe SplicePipe::Open() {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) == -1) {
+    throw std::system_error(errno, std::system_category(), "pipe open");
+  }
+  return SplicePipe{fds[0], fds[1]};
+}
+
+}  // namespace internal
+}  // namespace puddle
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace puddle {
+namespace internal {
+
+// SplicePipe is a kernel pipe used as an intermediate buffer to splice bytes
+// between two file descriptors, so the bytes are never copied to user space.
+class SplicePipe {
+ public:
+  SplicePipe(int read_fd = -1, int write_fd = -1);
+
+  ~SplicePipe();
+
+  SplicePipe(const SplicePipe& p) = delete;
+  SplicePipe& operator=(const SplicePipe& p) = delete;
+
+  SplicePipe(SplicePipe&& p);
+  SplicePipe& operator=(SplicePipe&& p);
+
+  // Returns the pipe capacity in bytes.
+  size_t capacity() const { return capacity_; }
+
+  // Splices up to size bytes from fd_in to fd_out via the pipe, returning the
+  // number of bytes spliced or 0 if fd_in is closed.
+  //
+  // off_in is the offset to read fd_in from, or -1 to read from the current
+  // position (which must be used for sockets and pipes).
+  size_t Splice(int fd_in, int64_t off_in, int fd_out, size_t size);
+
+  static SplicePipe Open();
+
+ private:
+  // Requested pipe capacity. The kernel default is 64KB, though a larger
+  // capacity means fewer operations per byte.
+  static constexpr int kCapacity = 1024 * 1024;
+
+  // Kernel default pipe capacity.
+  static constexpr int kDefaultCapacity = 64 * 1024;
+
+  int read_fd_ = -1;
+
+  int write_fd_ = -1;
+
+  size_t capacity_ = 0;
+};
+
+}  // namespace internal
+}  // namespace puddle
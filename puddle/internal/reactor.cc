@@ -1,7 +1,14 @@
 #include "puddle/internal/reactor.h"
 
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
 #include <cstring>
 
+#include "puddle/internal/watchdog.h"
+#include "puddle/log/timestamp.h"
+
 namespace puddle {
 namespace internal {
 
@@ -55,43 +62,142 @@ boost::intrusive_ptr<Context> ReactorContext::Spawn(Reactor* reactor) {
       boost::context::preallocated{storage, size, sctx}, salloc, reactor}};
 }
 
-BlockingRequest::BlockingRequest() : ctx_(Reactor::local()->active_) {}
+BlockingRequest::BlockingRequest(IoRequest* io)
+    : ctx_(Reactor::local()->active()), io_{io} {}
 
 int BlockingRequest::Wait() {
+#ifdef PUDDLE_TASK_TRACING
+  // Read the opcode before suspending, as the entry may be reused once
+  // submitted.
+  uint8_t opcode = sqe_ != nullptr ? sqe_->opcode : IORING_OP_LAST;
+  auto start = std::chrono::steady_clock::now();
+#endif
+
+  if (io_ != nullptr) {
+    io_->completion = this;
+    io_->priority = ctx_->priority();
+    Reactor::local()->io_scheduler()->Submit(io_);
+  }
+
   // Suspend the current fiber, then the reactor will wake us up once the
   // result is ready.
   Reactor::local()->Suspend();
+
+#ifdef PUDDLE_TASK_TRACING
+  Reactor::local()->tracer()->OnBlocked(
+      ctx_, opcode,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start));
+#endif
   return result_;
 }
 
 void BlockingRequest::Connect(int sockfd, struct sockaddr* addr,
                               socklen_t addrlen) {
-  struct io_uring_sqe* sqe = io_uring_get_sqe(&Reactor::local()->ring_);
+  struct io_uring_sqe* sqe = GetSqe();
   io_uring_prep_connect(sqe, sockfd, addr, addrlen);
-  io_uring_sqe_set_data(sqe, this);
 }
 
 void BlockingRequest::Accept(int sockfd, struct sockaddr* addr,
                              socklen_t* addrlen, int flags) {
-  struct io_uring_sqe* sqe = io_uring_get_sqe(&Reactor::local()->ring_);
+  struct io_uring_sqe* sqe = GetSqe();
   io_uring_prep_accept(sqe, sockfd, addr, addrlen, flags);
-  io_uring_sqe_set_data(sqe, this);
 }
 
 void BlockingRequest::Read(int fd, void* buf, unsigned nbytes, off_t offset) {
-  struct io_uring_sqe* sqe = io_uring_get_sqe(&Reactor::local()->ring_);
+  if (io_ != nullptr) {
+    io_->bytes = nbytes;
+  }
+  struct io_uring_sqe* sqe = GetSqe();
   io_uring_prep_read(sqe, fd, buf, nbytes, offset);
-  io_uring_sqe_set_data(sqe, this);
 }
 
 void BlockingRequest::Write(int fd, const void* buf, unsigned nbytes,
                             off_t offset) {
-  struct io_uring_sqe* sqe = io_uring_get_sqe(&Reactor::local()->ring_);
+  if (io_ != nullptr) {
+    io_->bytes = nbytes;
+  }
+  struct io_uring_sqe* sqe = GetSqe();
   io_uring_prep_write(sqe, fd, buf, nbytes, offset);
-  io_uring_sqe_set_data(sqe, this);
 }
 
-void BlockingRequest::SetResult(int result) {
+void BlockingRequest::Splice(int fd_in, int64_t off_in, int fd_out,
+                             int64_t off_out, unsigned nbytes,
+                             unsigned flags) {
+  struct io_uring_sqe* sqe = GetSqe();
+  io_uring_prep_splice(sqe, fd_in, off_in, fd_out, off_out, nbytes, flags);
+}
+
+void BlockingRequest::OpenAt(int dfd, const char* path, int flags,
+                             mode_t mode) {
+  struct io_uring_sqe* sqe = GetSqe();
+  io_uring_prep_openat(sqe, dfd, path, flags, mode);
+}
+
+void BlockingRequest::ReadFixed(int fd, void* buf, unsigned nbytes,
+                                off_t offset, int buf_index) {
+  if (io_ != nullptr) {
+    io_->bytes = nbytes;
+  }
+  struct io_uring_sqe* sqe = GetSqe();
+  io_uring_prep_read_fixed(sqe, fd, buf, nbytes, offset, buf_index);
+}
+
+void BlockingRequest::WriteFixed(int fd, const void* buf, unsigned nbytes,
+                                 off_t offset, int buf_index) {
+  if (io_ != nullptr) {
+    io_->bytes = nbytes;
+  }
+  struct io_uring_sqe* sqe = GetSqe();
+  io_uring_prep_write_fixed(sqe, fd, buf, nbytes, offset, buf_index);
+}
+
+void BlockingRequest::Fsync(int fd, unsigned flags) {
+  struct io_uring_sqe* sqe = GetSqe();
+  io_uring_prep_fsync(sqe, fd, flags);
+}
+
+void BlockingRequest::SendMsg(int fd, const struct msghdr* msg,
+                              unsigned flags) {
+  struct io_uring_sqe* sqe = GetSqe();
+  io_uring_prep_sendmsg(sqe, fd, msg, flags);
+}
+
+void BlockingRequest::RecvMsg(int fd, struct msghdr* msg, unsigned flags) {
+  struct io_uring_sqe* sqe = GetSqe();
+  io_uring_prep_recvmsg(sqe, fd, msg, flags);
+}
+
+void BlockingRequest::Cancel(Completion* completion) {
+  struct io_uring_sqe* sqe = GetSqe();
+  io_uring_prep_cancel(sqe, completion, 0);
+}
+
+void BlockingRequest::Nop() {
+  struct io_uring_sqe* sqe = GetSqe();
+  io_uring_prep_nop(sqe);
+}
+
+struct io_uring_sqe* BlockingRequest::GetSqe() {
+  struct io_uring_sqe* sqe;
+  if (io_ != nullptr) {
+    // Prepare the entry in the request, which the scheduler copies to the
+    // submission queue once dispatched.
+    sqe = &io_->sqe;
+    memset(sqe, 0, sizeof(*sqe));
+  } else {
+    sqe = Reactor::local()->GetSqe(this);
+  }
+#ifdef PUDDLE_TASK_TRACING
+  sqe_ = sqe;
+#endif
+  return sqe;
+}
+
+void BlockingRequest::Complete(int result, uint32_t flags) {
+  if (io_ != nullptr) {
+    Reactor::local()->io_scheduler()->Complete(io_);
+  }
   result_ = result;
   Reactor::local()->Schedule(ctx_);
 }
@@ -99,25 +205,83 @@ void BlockingRequest::SetResult(int result) {
 Reactor::Config Reactor::Config::Default() {
   Config config;
   config.ring_size = 1024;
+  config.ring_flags = 0;
+  config.cpu = -1;
+  config.stall_threshold = std::chrono::milliseconds{0};
+  config.scheduler = Scheduler::Config::Default();
+  config.io_scheduler = IoScheduler::Config::Default();
   return config;
 }
 
-Reactor::Reactor(Config config) : logger_{"reactor"} {
-  int res = io_uring_queue_init(config.ring_size, &ring_, 0);
+namespace {
+
+std::atomic<int> next_reactor_id{0};
+
+}  // namespace
+
+Reactor::Reactor(Config config)
+    : id_{next_reactor_id.fetch_add(1, std::memory_order_relaxed)},
+      scheduler_{config.scheduler},
+      io_scheduler_{this, config.io_scheduler},
+      metrics_{id_},
+#ifdef PUDDLE_TASK_TRACING
+      tracer_{id_},
+#endif
+      next_bgid_{0},
+      loop_epoch_{0},
+      watched_{false},
+      logger_{"reactor"} {
+  if (config.cpu != -1) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(config.cpu, &cpus);
+    int res = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (res != 0) {
+      logger_.Fatal("failed to pin reactor to cpu: {}: {}", config.cpu,
+                    strerror(res));
+    }
+  }
+
+  int res = io_uring_queue_init(config.ring_size, &ring_, config.ring_flags);
   if (res != 0) {
     logger_.Fatal("failed to setup io_uring: {}", strerror(-res));
   }
 
   reactor_context_ = internal::ReactorContext::Spawn(this);
+  reactor_context_->set_name("reactor");
+  scheduler_.set_reactor(reactor_context_.get());
   scheduler_.AddReady(reactor_context_.get());
 
   // The main context is the currently active context.
+  main_context_.set_name("main");
   active_ = &main_context_;
+  slice_start_ = std::chrono::steady_clock::now();
+
+  loop_time_ = std::chrono::system_clock::now();
+  log::SetCachedTime(&loop_time_);
+
+  if (config.stall_threshold.count() > 0) {
+    Watchdog::Config watchdog_config = Watchdog::Config::Default();
+    watchdog_config.threshold = config.stall_threshold;
+    Watchdog::Start(watchdog_config);
+    Watchdog::global()->Add(this);
+    watched_ = true;
+  }
 }
 
-Reactor::~Reactor() { io_uring_queue_exit(&ring_); }
+Reactor::~Reactor() {
+  if (watched_) {
+    Watchdog::global()->Remove(this);
+  }
+  log::SetCachedTime(nullptr);
+  io_uring_queue_exit(&ring_);
+}
 
 void Reactor::Yield() {
+  // Notify hooks before switching out the active context, such as to flush
+  // buffered writes.
+  active_->RunSuspendHooks();
+
   // The reactor context is always ready (unless we're in the reactor
   // context) so we'll always have another context to switch to.
   internal::Context* next = scheduler_.NextReady();
@@ -127,6 +291,13 @@ void Reactor::Yield() {
   internal::Context* prev = active_;
   scheduler_.AddReady(prev);
   active_ = next;
+  metrics_.context_switches.Inc();
+  if (scheduler_.cpu_accounting()) {
+    ChargeSlice(prev);
+  }
+#ifdef PUDDLE_TASK_TRACING
+  tracer_.OnSwitch(prev, next, EventType::kYield);
+#endif
 
   // Switch to the new context. As the underlying Boost context is "one shot",
   // we must update prev->context_ to the new state.
@@ -139,6 +310,8 @@ void Reactor::Yield() {
 }
 
 void Reactor::Suspend() {
+  active_->RunSuspendHooks();
+
   // The reactor context is always ready (unless we're in the reactor
   // context) so we'll always have another context to switch to.
   internal::Context* next = scheduler_.NextReady();
@@ -146,6 +319,13 @@ void Reactor::Suspend() {
 
   internal::Context* prev = active_;
   active_ = next;
+  metrics_.context_switches.Inc();
+  if (scheduler_.cpu_accounting()) {
+    ChargeSlice(prev);
+  }
+#ifdef PUDDLE_TASK_TRACING
+  tracer_.OnSwitch(prev, next, EventType::kSuspend);
+#endif
 
   // Switch to the new context. As the underlying Boost context is "one shot",
   // we must update prev->context_ to the new state.
@@ -157,10 +337,37 @@ void Reactor::Suspend() {
   });
 }
 
+void Reactor::ChargeSlice(Context* prev) {
+  auto now = std::chrono::steady_clock::now();
+  scheduler_.Charge(prev, now - slice_start_);
+  slice_start_ = now;
+}
+
 void Reactor::Schedule(Context* context) { scheduler_.AddReady(context); }
 
+struct io_uring_sqe* Reactor::GetSqe(Completion* completion) {
+  return GetSqe(completion, 1);
+}
+
+struct io_uring_sqe* Reactor::GetSqe(Completion* completion, unsigned n) {
+  if (io_uring_sq_space_left(&ring_) < n) {
+    // The submission queue is full so submit the pending entries to the
+    // kernel, which frees space for the new entries.
+    io_uring_submit(&ring_);
+  }
+
+  struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+  if (sqe == nullptr) {
+    logger_.Fatal("failed to get submission queue entry");
+  }
+  io_uring_sqe_set_data(sqe, completion);
+  return sqe;
+}
+
 boost::context::fiber Reactor::Terminate() {
   scheduler_.AddTerminating(active_);
+  metrics_.terminations.Inc();
+  metrics_.live_tasks.Add(-1);
 
   // The reactor context is always ready so we're guaranteed to have another
   // context to switch to.
@@ -168,6 +375,13 @@ boost::context::fiber Reactor::Terminate() {
 
   internal::Context* prev = active_;
   active_ = next;
+  metrics_.context_switches.Inc();
+  if (scheduler_.cpu_accounting()) {
+    ChargeSlice(prev);
+  }
+#ifdef PUDDLE_TASK_TRACING
+  tracer_.OnSwitch(prev, next, EventType::kTerminate);
+#endif
 
   // Switch to the new context. As the underlying Boost context is "one shot",
   // we must update prev->context_ to the new state.
@@ -180,17 +394,54 @@ boost::context::fiber Reactor::Terminate() {
       });
 }
 
+int Reactor::RegisterBuffers(const struct iovec* iovecs, unsigned n) {
+  return io_uring_register_buffers(&ring_, iovecs, n);
+}
+
+int Reactor::UnregisterBuffers() { return io_uring_unregister_buffers(&ring_); }
+
+struct io_uring_buf_ring* Reactor::SetupBufRing(unsigned entries, int* bgid,
+                                                int* err) {
+  *bgid = next_bgid_++;
+  return io_uring_setup_buf_ring(&ring_, entries, *bgid, 0, err);
+}
+
+void Reactor::FreeBufRing(struct io_uring_buf_ring* buf_ring, unsigned entries,
+                          int bgid) {
+  io_uring_free_buf_ring(&ring_, buf_ring, entries, bgid);
+}
+
 void Reactor::Run() {
   while (true) {
-    io_uring_submit_and_get_events(&ring_);
+    int submitted = io_uring_submit_and_get_events(&ring_);
+    loop_time_ = std::chrono::system_clock::now();
+    metrics_.loop_iterations.Inc();
+    if (submitted > 0) {
+      metrics_.sqes_submitted.Inc(submitted);
+      metrics_.sqes_per_submit.Add(submitted);
+#ifdef PUDDLE_TASK_TRACING
+      tracer_.OnSubmit(submitted);
+#endif
+    }
     DispatchEvents();
 
     scheduler_.WakeSleeping();
     scheduler_.ReleaseTerminating();
 
+    metrics_.ready_tasks.Set(scheduler_.ready());
+    metrics_.sleeping_tasks.Set(scheduler_.sleeping());
+    metrics_.io_queued.Set(io_scheduler_.queued());
+    metrics_.io_in_flight.Set(io_scheduler_.in_flight());
+
     // If there are ready contexts, yield so they can run.
     if (scheduler_.has_ready()) {
+      // Mark the reactor as running tasks for the watchdog. Only the reactor
+      // thread updates the epoch so doesn't need an atomic increment.
+      loop_epoch_.store(loop_epoch_.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
       Yield();
+      loop_epoch_.store(loop_epoch_.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
       continue;
     }
 
@@ -217,7 +468,11 @@ void Reactor::Run() {
     }
 
     struct io_uring_cqe* cqe_ptr = nullptr;
+    auto wait_start = std::chrono::steady_clock::now();
     io_uring_wait_cqes(&ring_, &cqe_ptr, 1, ts_arg, NULL);
+    metrics_.wait_ns.Inc(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - wait_start)
+                             .count());
     DispatchEvents();
   }
 }
@@ -235,14 +490,20 @@ void Reactor::DispatchEvents() {
   struct io_uring_cqe* cqe;
   io_uring_for_each_cqe(&ring_, ring_head, cqe) {
     cqe_count++;
-
-    // Set the request result to wake the context.
-    BlockingRequest* req =
-        static_cast<BlockingRequest*>(io_uring_cqe_get_data(cqe));
-    req->SetResult(cqe->res);
+#ifdef PUDDLE_TASK_TRACING
+    tracer_.OnComplete(cqe->res);
+#endif
+
+    // Pass the result to the operation's completion (such as a
+    // BlockingRequest which wakes the waiting context).
+    Completion* completion =
+        static_cast<Completion*>(io_uring_cqe_get_data(cqe));
+    completion->Complete(cqe->res, cqe->flags);
   }
   if (cqe_count) {
     io_uring_cq_advance(&ring_, cqe_count);
+    metrics_.cqes_dispatched.Inc(cqe_count);
+    metrics_.cqes_per_dispatch.Add(cqe_count);
   }
 
   logger_.Debug("dispatched events; events = {}", cqe_count);
@@ -3,21 +3,48 @@
 #include <liburing.h>
 #include <netinet/in.h>
 
+#include <atomic>
+#include <chrono>
+
 #include "boost/intrusive_ptr.hpp"
 #include "puddle/internal/context.h"
+#include "puddle/internal/io_scheduler.h"
+#include "puddle/internal/metrics.h"
 #include "puddle/internal/scheduler.h"
+#include "puddle/internal/trace.h"
 #include "puddle/log/log.h"
 
 namespace puddle {
 namespace internal {
 
+// Completion handles the result of an operation submitted to the reactor
+// (io_uring).
+//
+// The reactor calls Complete from the reactor context when the operation's
+// completion event is dispatched, with the events result and flags. Multishot
+// operations may complete many times, where IORING_CQE_F_MORE is set in flags
+// if more completions will follow.
+class Completion {
+ public:
+  virtual void Complete(int result, uint32_t flags) = 0;
+
+ protected:
+  ~Completion() = default;
+};
+
 // BlockingRequest requests a operation from the reactor (io_uring), then
 // blocks the current context until the result is ready.
 //
 // This is similar to a future/promise, except it is not thread safe.
-class BlockingRequest {
+class BlockingRequest final : public Completion {
  public:
-  BlockingRequest();
+  BlockingRequest() : BlockingRequest{nullptr} {}
+
+  // Creates a request queued by the reactors IoScheduler using the given
+  // IoRequest, which must outlive the request, rather than submitted as soon
+  // as it's prepared. Only for operations that complete without waiting on a
+  // peer, such as file reads and writes.
+  explicit BlockingRequest(IoRequest* io);
 
   int Wait();
 
@@ -29,12 +56,50 @@ class BlockingRequest {
 
   void Write(int fd, const void* buf, unsigned nbytes, off_t offset);
 
-  void SetResult(int result);
+  void Splice(int fd_in, int64_t off_in, int fd_out, int64_t off_out,
+              unsigned nbytes, unsigned flags);
+
+  void OpenAt(int dfd, const char* path, int flags, mode_t mode);
+
+  // Reads into a buffer registered with Reactor::RegisterBuffers.
+  void ReadFixed(int fd, void* buf, unsigned nbytes, off_t offset,
+                 int buf_index);
+
+  // Writes from a buffer registered with Reactor::RegisterBuffers.
+  void WriteFixed(int fd, const void* buf, unsigned nbytes, off_t offset,
+                  int buf_index);
+
+  void Fsync(int fd, unsigned flags);
+
+  void SendMsg(int fd, const struct msghdr* msg, unsigned flags);
+
+  void RecvMsg(int fd, struct msghdr* msg, unsigned flags);
+
+  // Cancels the pending operations submitted with the given completion.
+  void Cancel(Completion* completion);
+
+  // Submits an operation that does nothing, which measures the cost of an
+  // io_uring round trip.
+  void Nop();
+
+  void Complete(int result, uint32_t flags) override;
 
  private:
+  // Returns a submission queue entry for the request.
+  struct io_uring_sqe* GetSqe();
+
   internal::Context* ctx_;
 
   int result_;
+
+  // Operation queued by the IoScheduler, or nullptr if submitted directly.
+  IoRequest* io_;
+
+#ifdef PUDDLE_TASK_TRACING
+  // Entry of the last prepared operation, used to trace the operation the
+  // context is blocked on.
+  struct io_uring_sqe* sqe_ = nullptr;
+#endif
 };
 
 // Reactor manages scheduling tasks and asynchronous IO.
@@ -57,6 +122,23 @@ class Reactor {
     // io_uring ring size.
     int ring_size;
 
+    // io_uring setup flags, such as IORING_SETUP_SQPOLL or
+    // IORING_SETUP_COOP_TASKRUN.
+    unsigned ring_flags;
+
+    // CPU to pin the reactor thread to, or -1 to not pin the thread.
+    int cpu;
+
+    // If non-zero, the reactor is watched by the global Watchdog, which
+    // reports tasks that run for longer than the threshold without yielding.
+    // The watchdog is shared by all reactors, so uses the threshold of the
+    // first reactor to enable it.
+    std::chrono::milliseconds stall_threshold;
+
+    Scheduler::Config scheduler;
+
+    IoScheduler::Config io_scheduler;
+
     static Config Default();
   };
 
@@ -76,15 +158,32 @@ class Reactor {
   // Spawn a task context.
   template <typename Fn, typename... Arg>
   boost::intrusive_ptr<Context> Spawn(Fn&& fn, Arg&&... arg) {
+    return SpawnWithPriority(Priority::kNormal, std::forward<Fn>(fn),
+                             std::forward<Arg>(arg)...);
+  }
+
+  // Spawn a task context with the given priority.
+  template <typename Fn, typename... Arg>
+  boost::intrusive_ptr<Context> SpawnWithPriority(Priority priority, Fn&& fn,
+                                                  Arg&&... arg) {
     auto context = internal::TaskContext<Fn, Arg...>::Spawn(
         std::forward<Fn>(fn), std::forward<Arg>(arg)...);
+    context->set_priority(priority);
     scheduler_.AddReady(context.get());
+    metrics_.spawns.Inc();
+#ifdef PUDDLE_TASK_TRACING
+    tracer_.OnSpawn(context.get());
+#endif
+    metrics_.live_tasks.Add(1);
     return context;
   }
 
   // Yield the current context so the scheduler can switch to another context.
   // The current context will be added to the schedulers ready queue to be
   // scheduled again.
+  //
+  // Any suspend hooks registered with the current context are notified before
+  // switching.
   void Yield();
 
   // Suspend the current context, which is the same as yield except the current
@@ -101,6 +200,16 @@ class Reactor {
   // Schedule adds the context to the ready queue.
   void Schedule(Context* context);
 
+  // Returns a submission queue entry whose completion will be passed to the
+  // given completion. If the submission queue is full, pending entries are
+  // submitted to make space.
+  struct io_uring_sqe* GetSqe(Completion* completion);
+
+  // Returns a submission queue entry, like GetSqe, though guarantees there is
+  // space for n entries in the submission queue. This is required for linked
+  // entries, which must be submitted together.
+  struct io_uring_sqe* GetSqe(Completion* completion, unsigned n);
+
   // Adds the active context to the schedulers terminating queue, then
   // releases the context from the reactor context.
   //
@@ -111,9 +220,60 @@ class Reactor {
   // must return the next context to run.
   boost::context::fiber Terminate();
 
+  // Registers buffers with io_uring so the kernel doesn't have to map the
+  // buffers pages for each operation. Buffers are identified by their index
+  // in iovecs.
+  //
+  // Only one set of buffers can be registered at a time. Returns 0 on success
+  // or a negative errno.
+  int RegisterBuffers(const struct iovec* iovecs, unsigned n);
+
+  // Unregisters buffers registered with RegisterBuffers.
+  int UnregisterBuffers();
+
+  // Sets up a ring of provided buffers with the given number of entries
+  // (which must be a power of 2), which the kernel selects buffers from for
+  // operations using IOSQE_BUFFER_SELECT.
+  //
+  // Sets bgid to the buffer group ID to select buffers from. Returns nullptr
+  // and sets err to a negative errno on failure.
+  struct io_uring_buf_ring* SetupBufRing(unsigned entries, int* bgid,
+                                         int* err);
+
+  // Frees a buffer ring set up with SetupBufRing.
+  void FreeBufRing(struct io_uring_buf_ring* buf_ring, unsigned entries,
+                   int bgid);
+
   // Runs the reactor event loop.
   void Run();
 
+  // Returns the time at the start of the current event loop iteration. This
+  // avoids reading the clock where an approximate time is enough, such as to
+  // timestamp logs.
+  std::chrono::system_clock::time_point loop_time() const {
+    return loop_time_;
+  }
+
+  // Returns the loop epoch, which is incremented when the reactor switches
+  // from its event loop to run tasks, and again when it returns. The epoch is
+  // odd while tasks are running, so a reactor is stalled if the epoch is odd
+  // and unchanged for too long. May be read from any thread.
+  uint64_t loop_epoch() const {
+    return loop_epoch_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the reactor ID, which is unique within the process.
+  int id() const { return id_; }
+
+  IoScheduler* io_scheduler() { return &io_scheduler_; }
+
+  // Returns the reactors runtime metrics.
+  const ReactorMetrics& metrics() const { return metrics_; }
+
+#ifdef PUDDLE_TASK_TRACING
+  TaskTracer* tracer() { return &tracer_; }
+#endif
+
   // Returns the reactor in the local thread.
   static Reactor* local() { return local_; }
 
@@ -121,16 +281,27 @@ class Reactor {
   static void Start(Config config);
 
  private:
-  // Required for access to ring_.
-  friend BlockingRequest;
-
   static thread_local Reactor* local_;
 
   // Dispatches events on the io_uring completion queue.
   void DispatchEvents();
 
+  // Charges the context switched out with the time it ran, when the
+  // scheduler shares by time.
+  void ChargeSlice(Context* prev);
+
+  int id_;
+
   Scheduler scheduler_;
 
+  IoScheduler io_scheduler_;
+
+  ReactorMetrics metrics_;
+
+#ifdef PUDDLE_TASK_TRACING
+  TaskTracer tracer_;
+#endif
+
   // Active context thats currently running.
   Context* active_;
 
@@ -141,6 +312,20 @@ class Reactor {
 
   io_uring ring_;
 
+  // Next buffer group ID to assign to a buffer ring.
+  int next_bgid_;
+
+  std::chrono::system_clock::time_point loop_time_;
+
+  std::atomic<uint64_t> loop_epoch_;
+
+  // Time the active context was switched to, when the scheduler shares by
+  // time.
+  std::chrono::steady_clock::time_point slice_start_;
+
+  // Whether the reactor is watched by the watchdog.
+  bool watched_;
+
   log::Logger logger_;
 };
 
@@ -0,0 +1,168 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "puddle/internal/context.h"
+#include "puddle/internal/reactor.h"
+#include "puddle/internal/scheduler.h"
+#include "puddle/internal/sync.h"
+#include "puddle/puddle.h"
+
+// Benchmarks of the scheduler and context switch hot paths.
+//
+// Benchmarks run in the main context of the reactor started in main, so can
+// spawn and switch to other tasks. Note the reactor context is always ready,
+// so every switch through the ready queue also runs an iteration of the
+// reactor event loop.
+
+namespace {
+
+void BM_SpawnJoin(benchmark::State& state) {
+  for (auto _ : state) {
+    puddle::Spawn([] {}).Join();
+  }
+}
+
+BENCHMARK(BM_SpawnJoin);
+
+// Two tasks (the benchmark and a spawned task) yielding to each other.
+void BM_YieldPingPong(benchmark::State& state) {
+  bool done = false;
+  puddle::Task task = puddle::Spawn([&] {
+    while (!done) {
+      puddle::Yield();
+    }
+  });
+
+  for (auto _ : state) {
+    puddle::Yield();
+  }
+
+  done = true;
+  task.Join();
+}
+
+BENCHMARK(BM_YieldPingPong);
+
+// Two tasks taking turns to schedule the other then suspend.
+void BM_SuspendSchedule(benchmark::State& state) {
+  puddle::internal::Reactor* reactor = puddle::internal::Reactor::local();
+  puddle::internal::Context* main = reactor->active();
+
+  bool done = false;
+  puddle::internal::Context* task_context = nullptr;
+  puddle::Task task = puddle::Spawn([&] {
+    task_context = reactor->active();
+    while (!done) {
+      reactor->Schedule(main);
+      reactor->Suspend();
+    }
+    reactor->Schedule(main);
+  });
+  // Run the task until it first suspends.
+  reactor->Suspend();
+
+  for (auto _ : state) {
+    reactor->Schedule(task_context);
+    reactor->Suspend();
+  }
+
+  done = true;
+  reactor->Schedule(task_context);
+  reactor->Suspend();
+  task.Join();
+}
+
+BENCHMARK(BM_SuspendSchedule);
+
+void BM_SleepForZero(benchmark::State& state) {
+  for (auto _ : state) {
+    puddle::SleepFor(std::chrono::nanoseconds{0});
+  }
+}
+
+BENCHMARK(BM_SleepForZero);
+
+// Adds a context to a sleep queue containing state.range(0) other contexts,
+// then wakes it. Uses a standalone scheduler so the sleeping contexts don't
+// affect the reactor.
+void BM_SleepQueueInsert(benchmark::State& state) {
+  // Declared before the scheduler so the scheduler is destroyed first, which
+  // unlinks the contexts still in its sleep queue.
+  std::vector<std::unique_ptr<puddle::internal::Context>> sleeping;
+  puddle::internal::Context context;
+
+  puddle::internal::Scheduler scheduler;
+
+  auto now = std::chrono::steady_clock::now();
+  std::mt19937_64 rng{42};
+  std::uniform_int_distribution<int> seconds{60, 3600};
+  for (int64_t i = 0; i != state.range(0); i++) {
+    sleeping.push_back(std::make_unique<puddle::internal::Context>());
+    scheduler.AddSleep(sleeping.back().get(),
+                       now + std::chrono::seconds{seconds(rng)});
+  }
+
+  for (auto _ : state) {
+    // A deadline that has passed is woken immediately.
+    scheduler.AddSleep(&context, now);
+    scheduler.WakeSleeping();
+    benchmark::DoNotOptimize(scheduler.NextReady());
+  }
+}
+
+BENCHMARK(BM_SleepQueueInsert)->RangeMultiplier(8)->Range(1, 1 << 15);
+
+// Notifies a task waiting on a wait queue, then yields so it can wait again.
+void BM_WaitQueueNotify(benchmark::State& state) {
+  puddle::internal::Reactor* reactor = puddle::internal::Reactor::local();
+  puddle::internal::WaitQueue queue;
+
+  bool done = false;
+  puddle::Task task = puddle::Spawn([&] {
+    while (!done) {
+      queue.SuspendAndWait(reactor->active());
+    }
+  });
+  // Run the task until it first waits.
+  puddle::Yield();
+
+  for (auto _ : state) {
+    queue.NotifyOne();
+    puddle::Yield();
+  }
+
+  done = true;
+  queue.NotifyOne();
+  task.Join();
+}
+
+BENCHMARK(BM_WaitQueueNotify);
+
+// Submits an IORING_OP_NOP and waits for its completion.
+void BM_NopRoundTrip(benchmark::State& state) {
+  for (auto _ : state) {
+    puddle::internal::BlockingRequest req;
+    req.Nop();
+    benchmark::DoNotOptimize(req.Wait());
+  }
+}
+
+BENCHMARK(BM_NopRoundTrip);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Start the Puddle runtime so benchmarks run in the reactors main context.
+  puddle::Start();
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
@@ -3,21 +3,112 @@
 namespace puddle {
 namespace internal {
 
-void Scheduler::AddReady(Context* context) { ready_queue_.push_back(*context); }
+namespace {
+
+// Usage after which the normal and background usage is halved, so the share
+// reflects recent usage.
+constexpr uint64_t kRunsWindow = 1024;
+
+constexpr uint64_t kTimeWindowNs = 10'000'000;
+
+}  // namespace
+
+Scheduler::Config Scheduler::Config::Default() {
+  Config config;
+  config.background_share = 0.1;
+  config.cpu_accounting = false;
+  return config;
+}
+
+Scheduler::Scheduler(Config config) : config_{config} {}
+
+void Scheduler::AddReady(Context* context) {
+#ifdef PUDDLE_TASK_TRACING
+  context->ready_tp_ = std::chrono::steady_clock::now();
+#endif
+  if (context == reactor_) {
+    // The reactor runs again once the contexts ready now have had a turn.
+    reactor_ready_ = true;
+    turn_remaining_ = ready_;
+    return;
+  }
+  PushReady(context);
+}
 
 Context* Scheduler::NextReady() {
-  if (ready_queue_.empty()) {
+  if ((turn_remaining_ == 0 || ready_ == 0) && reactor_ready_) {
+    reactor_ready_ = false;
+    return reactor_;
+  }
+  if (ready_ == 0) {
     return nullptr;
   }
-  Context* next = &ready_queue_.front();
-  ready_queue_.pop_front();
+
+  Priority priority = Priority::kLatency;
+  if (ready_queues_[static_cast<size_t>(Priority::kLatency)].empty()) {
+    priority = PickShared();
+  }
+
+  ReadyQueueType& queue = ready_queues_[static_cast<size_t>(priority)];
+  Context* next = &queue.front();
+  queue.pop_front();
+  ready_--;
+  if (turn_remaining_ > 0) {
+    turn_remaining_--;
+  }
+  if (!config_.cpu_accounting) {
+    AddUsage(priority, 1);
+  }
   return next;
 }
 
+void Scheduler::Charge(Context* context, std::chrono::nanoseconds ran) {
+  if (context != reactor_) {
+    AddUsage(context->priority(), ran.count());
+  }
+}
+
+void Scheduler::PushReady(Context* context) {
+  ready_queues_[static_cast<size_t>(context->priority())].push_back(*context);
+  ready_++;
+}
+
+Priority Scheduler::PickShared() const {
+  bool normal_ready =
+      !ready_queues_[static_cast<size_t>(Priority::kNormal)].empty();
+  bool background_ready =
+      !ready_queues_[static_cast<size_t>(Priority::kBackground)].empty();
+  if (normal_ready && background_ready) {
+    // Run background contexts only while under their share.
+    uint64_t total = normal_usage_ + background_usage_;
+    return background_usage_ < config_.background_share * total
+               ? Priority::kBackground
+               : Priority::kNormal;
+  }
+  return normal_ready ? Priority::kNormal : Priority::kBackground;
+}
+
+void Scheduler::AddUsage(Priority priority, uint64_t usage) {
+  if (priority == Priority::kNormal) {
+    normal_usage_ += usage;
+  } else if (priority == Priority::kBackground) {
+    background_usage_ += usage;
+  } else {
+    return;
+  }
+
+  uint64_t window = config_.cpu_accounting ? kTimeWindowNs : kRunsWindow;
+  if (normal_usage_ + background_usage_ > window) {
+    normal_usage_ /= 2;
+    background_usage_ /= 2;
+  }
+}
+
 void Scheduler::AddSleep(Context* context,
                          const std::chrono::steady_clock::time_point& tp) {
   context->sleep_tp_ = tp;
   sleep_queue_.insert(*context);
+  sleeping_++;
 }
 
 std::chrono::steady_clock::time_point Scheduler::NextSleep() {
@@ -40,7 +131,11 @@ void Scheduler::WakeSleeping() {
     Context* c = &(*it);
     if (c->sleep_tp_ <= now) {
       it = sleep_queue_.erase(it);
-      ready_queue_.push_back(*c);
+      sleeping_--;
+#ifdef PUDDLE_TASK_TRACING
+      c->ready_tp_ = now;
+#endif
+      PushReady(c);
     } else {
       return;
     }
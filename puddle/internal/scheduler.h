@@ -11,10 +11,41 @@ namespace puddle {
 namespace internal {
 
 // Schedules contexts on the local thread.
+//
+// Ready contexts are queued by priority class (see Priority). The reactor
+// context is queued separately and runs once every context that was ready
+// when it last ran has had a turn, as if it were at the back of a single FIFO
+// queue, so no class can starve the event loop.
+//
+// Within each turn, ready latency contexts always run first. Normal and
+// background contexts then share the reactor, where background contexts get
+// at most background_share when normal contexts are also ready. By default
+// the share is of the number of times contexts run. With cpu_accounting, it
+// is the share of time, which requires the reactor to read the clock on
+// every switch (see Charge).
 class Scheduler {
  public:
+  struct Config {
+    // Maximum share (from 0 to 1) of the reactor given to background
+    // contexts when normal contexts are also ready.
+    double background_share;
+
+    // Whether to share by time rather than number of runs.
+    bool cpu_accounting;
+
+    static Config Default();
+  };
+
+  explicit Scheduler(Config config = Config::Default());
+
   // Returns whether there are contexts in the ready queue.
-  bool has_ready() const { return !ready_queue_.empty(); }
+  bool has_ready() const { return ready_ > 0; }
+
+  // Returns the number of contexts in the ready queue.
+  size_t ready() const { return ready_; }
+
+  // Returns the number of contexts in the sleep queue.
+  size_t sleeping() const { return sleeping_; }
 
   // Adds the context to the ready queue.
   void AddReady(Context* context);
@@ -23,6 +54,16 @@ class Scheduler {
   // queue is empty.
   Context* NextReady();
 
+  // Sets the reactor context, which is scheduled separately from the other
+  // contexts.
+  void set_reactor(Context* reactor) { reactor_ = reactor; }
+
+  bool cpu_accounting() const { return config_.cpu_accounting; }
+
+  // Charges the context with running for the given duration, when sharing by
+  // time.
+  void Charge(Context* context, std::chrono::nanoseconds ran);
+
   // Adds the context to the sleep queue. The context will be added to the
   // ready queue when the given time is reached.
   void AddSleep(Context* context,
@@ -67,11 +108,42 @@ class Scheduler {
                                     &Context::terminated_hook_>,
       boost::intrusive::linear<true>, boost::intrusive::cache_last<true>>;
 
-  ReadyQueueType ready_queue_;
+  // Adds the context to the ready queue for its priority.
+  void PushReady(Context* context);
+
+  // Returns the class of normal or background contexts to run next.
+  Priority PickShared() const;
+
+  // Adds usage to the normal or background class.
+  void AddUsage(Priority priority, uint64_t usage);
+
+  Config config_;
+
+  // Ready queues indexed by priority.
+  ReadyQueueType ready_queues_[kPriorities];
+
+  Context* reactor_ = nullptr;
+
+  bool reactor_ready_ = false;
+
+  // Number of contexts to run before the reactor context.
+  size_t turn_remaining_ = 0;
+
+  // Recent usage of the normal and background classes, in either runs or
+  // nanoseconds, which decays so the share adapts.
+  uint64_t normal_usage_ = 0;
+
+  uint64_t background_usage_ = 0;
 
   SleepQueueType sleep_queue_;
 
   TerminateQueueType terminate_queue_;
+
+  // The queues don't track their size (to make unlinking constant time), so
+  // track the sizes separately. ready_ excludes the reactor context.
+  size_t ready_ = 0;
+
+  size_t sleeping_ = 0;
 };
 
 }  // namespace internal
@@ -0,0 +1,210 @@
+#include "puddle/internal/socket.h"
+
+#include <linux/filter.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <system_error>
+
+#include "puddle/internal/reactor.h"
+
+namespace puddle {
+namespace internal {
+
+Socket::Socket(int socket) : socket_{socket} {}
+
+Socket::~Socket() {
+  if (socket_ != -1) {
+    close(socket_);
+  }
+}
+
+Socket::Socket(Socket&& s) {
+  socket_ = s.socket_;
+  s.socket_ = -1;
+}
+
+Socket& Socket::operator=(Socket&& s) {
+  std::swap(socket_, s.socket_);
+  return *this;
+}
+
+void Socket::Bind(const SocketAddr& addr, bool reuse_port) {
+  if (addr.family() == AF_INET || addr.family() == AF_INET6) {
+    SetOption(SOL_SOCKET, SO_REUSEADDR, 1);
+    if (reuse_port) {
+      SetOption(SOL_SOCKET, SO_REUSEPORT, 1);
+    }
+  }
+  if (addr.family() == AF_INET6) {
+    // Accept IPv4 connections (as IPv4-mapped IPv6 addresses) regardless of
+    // the net.ipv6.bindv6only default.
+    SetOption(IPPROTO_IPV6, IPV6_V6ONLY, 0);
+  }
+
+  if (bind(socket_, addr.addr(), addr.len) == -1) {
+    throw std::system_error(errno, std::system_category(), "socket bind");
+  }
+}
+
+void Socket::AttachReusePortCpuSteering(int sockets) {
+  // Returns the CPU that processed the packet modulo the number of sockets,
+  // which is used as the index of the socket in the reuseport group.
+  struct sock_filter code[] = {
+      {BPF_LD | BPF_W | BPF_ABS, 0, 0,
+       static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU)},
+      {BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(sockets)},
+      {BPF_RET | BPF_A, 0, 0, 0},
+  };
+  struct sock_fprog prog;
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+
+  if (setsockopt(socket_, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog,
+                 sizeof(prog)) == -1) {
+    throw std::system_error(errno, std::system_category(), "socket option");
+  }
+}
+
+void Socket::Listen(int backlog) {
+  if (listen(socket_, backlog) == -1) {
+    throw std::system_error(errno, std::system_category(), "socket listen");
+  }
+}
+
+Socket Socket::Accept() {
+  struct sockaddr_storage client_addr;
+  socklen_t addr_len = sizeof(client_addr);
+
+  BlockingRequest r;
+  r.Accept(socket_, (struct sockaddr*)&client_addr, &addr_len, SOCK_CLOEXEC);
+  int conn = r.Wait();
+  if (conn < 0) {
+    throw std::system_error(-conn, std::system_category(), "socket accept");
+  }
+
+  return Socket{conn};
+}
+
+void Socket::Connect(const SocketAddr& addr) {
+  // Copy the address as it must remain valid until the connect completes.
+  SocketAddr sock_addr = addr;
+
+  BlockingRequest r;
+  r.Connect(socket_, sock_addr.addr(), sock_addr.len);
+  int res = r.Wait();
+  if (res < 0) {
+    throw std::system_error(-res, std::system_category(), "socket connect");
+  }
+}
+
+size_t Socket::Read(uint8_t* buf, size_t size) {
+  BlockingRequest r;
+  r.Read(socket_, buf, size, 0);
+  int read_n = r.Wait();
+  if (read_n < 0) {
+    throw std::system_error(-read_n, std::system_category(), "socket read");
+  }
+  return read_n;
+}
+
+size_t Socket::Write(const uint8_t* buf, size_t size) {
+  BlockingRequest r;
+  r.Write(socket_, buf, size, 0);
+  int write_n = r.Wait();
+  if (write_n < 0) {
+    throw std::system_error(-write_n, std::system_category(), "socket write");
+  }
+  return write_n;
+}
+
+void Socket::WriteAsync(const uint8_t* buf, size_t size,
+                        Completion* completion) {
+  struct io_uring_sqe* sqe = Reactor::local()->GetSqe(completion);
+  io_uring_prep_write(sqe, socket_, buf, size, 0);
+}
+
+size_t Socket::WriteFds(const uint8_t* buf, size_t size,
+                        const std::vector<int>& fds) {
+  struct iovec iov {
+    const_cast<uint8_t*>(buf), size
+  };
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  std::vector<uint8_t> control;
+  if (!fds.empty()) {
+    control.resize(CMSG_SPACE(sizeof(int) * fds.size()));
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+  }
+
+  BlockingRequest r;
+  r.SendMsg(socket_, &msg, 0);
+  int write_n = r.Wait();
+  if (write_n < 0) {
+    throw std::system_error(-write_n, std::system_category(), "socket write");
+  }
+  return write_n;
+}
+
+size_t Socket::ReadFds(uint8_t* buf, size_t size, std::vector<int>* fds) {
+  struct iovec iov {
+    buf, size
+  };
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  alignas(struct cmsghdr) uint8_t control[CMSG_SPACE(sizeof(int) * kMaxFds)];
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  BlockingRequest r;
+  r.RecvMsg(socket_, &msg, MSG_CMSG_CLOEXEC);
+  int read_n = r.Wait();
+  if (read_n < 0) {
+    throw std::system_error(-read_n, std::system_category(), "socket read");
+  }
+
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (size_t i = 0; i != n; i++) {
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+        fds->push_back(fd);
+      }
+    }
+  }
+
+  return read_n;
+}
+
+void Socket::SetOption(int level, int name, int value) {
+  if (setsockopt(socket_, level, name, &value, sizeof(value)) == -1) {
+    throw std::system_error(errno, std::system_category(), "socket option");
+  }
+}
+
+Socket Socket::Open(int family) {
+  int s = socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (s == -1) {
+    throw std::system_error(errno, std::system_category(), "socket open");
+  }
+  return Socket{s};
+}
+
+}  // namespace internal
+}  // namespace puddle
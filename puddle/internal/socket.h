@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "puddle/internal/addr.h"
+
+namespace puddle {
+namespace internal {
+
+class Completion;
+
+// Socket is a stream socket, such as a TCP or Unix domain socket.
+class Socket {
+ public:
+  Socket(int socket = -1);
+
+  ~Socket();
+
+  Socket(const Socket& s) = delete;
+  Socket& operator=(const Socket& s) = delete;
+
+  Socket(Socket&& s);
+  Socket& operator=(Socket&& s);
+
+  int fd() const { return socket_; }
+
+  // Binds the socket to the address. If reuse_port is true, sets
+  // SO_REUSEPORT so multiple sockets can bind to the same address, where the
+  // kernel distributes incoming connections between them.
+  //
+  // IPv6 sockets are dual-stack, so binding to [::] accepts both IPv4 and
+  // IPv6 connections.
+  void Bind(const SocketAddr& addr, bool reuse_port = false);
+
+  // Attaches a classic BPF program to the sockets SO_REUSEPORT group which
+  // selects the socket to receive a connection by the CPU that processed the
+  // connections packets, modulo the number of sockets in the group. So the
+  // i'th socket bound to the address receives connections processed by CPUs
+  // i, i + n, i + 2n, ...
+  void AttachReusePortCpuSteering(int sockets);
+
+  void Listen(int backlog);
+
+  Socket Accept();
+
+  void Connect(const SocketAddr& addr);
+
+  size_t Read(uint8_t* buf, size_t size);
+
+  size_t Write(const uint8_t* buf, size_t size);
+
+  // Submits a write without blocking. The result (bytes written or negative
+  // errno) is passed to the completion, so the buffer must remain valid until
+  // then.
+  void WriteAsync(const uint8_t* buf, size_t size, Completion* completion);
+
+  // Writes up to size bytes along with the given file descriptors, which are
+  // passed with a SCM_RIGHTS control message. Only supported by Unix domain
+  // sockets.
+  size_t WriteFds(const uint8_t* buf, size_t size, const std::vector<int>& fds);
+
+  // Reads up to size bytes, and appends any file descriptors received with a
+  // SCM_RIGHTS control message to fds. Only supported by Unix domain sockets.
+  //
+  // At most kMaxFds file descriptors can be received per read, and any
+  // additional descriptors are discarded by the kernel.
+  size_t ReadFds(uint8_t* buf, size_t size, std::vector<int>* fds);
+
+  // Opens a stream socket with the given address family (such as AF_INET or
+  // AF_UNIX).
+  static Socket Open(int family);
+
+  static constexpr int kMaxFds = 32;
+
+ private:
+  void SetOption(int level, int name, int value);
+
+  int socket_ = -1;
+};
+
+}  // namespace internal
+}  // namespace puddle
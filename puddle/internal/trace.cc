@@ -0,0 +1,347 @@
+#include "puddle/internal/trace.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include "fmt/format.h"
+#include "puddle/internal/context.h"
+#include "puddle/stats/registry.h"
+
+#ifdef PUDDLE_TASK_TRACING
+
+namespace puddle {
+namespace internal {
+
+namespace {
+
+std::mutex tracers_mu;
+
+// Tracers of all reactors.
+std::vector<TaskTracer*> tracers;
+
+uint64_t NowNs(std::chrono::steady_clock::time_point tp) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             tp.time_since_epoch())
+      .count();
+}
+
+const char* SwitchName(EventType type) {
+  switch (type) {
+    case EventType::kYield:
+      return "yield";
+    case EventType::kSuspend:
+      return "suspend";
+    default:
+      return "terminate";
+  }
+}
+
+// Escapes a JSON string, where task names are expected to be simple
+// identifiers so only quotes, backslashes and control characters are
+// handled.
+std::string EscapeJson(const char* s) {
+  std::string escaped;
+  for (; *s != '\0'; ++s) {
+    if (*s == '"' || *s == '\\') {
+      escaped += '\\';
+      escaped += *s;
+    } else if (static_cast<unsigned char>(*s) < 0x20) {
+      escaped += fmt::format("\\u{:04x}", *s);
+    } else {
+      escaped += *s;
+    }
+  }
+  return escaped;
+}
+
+// Returns the name of the io_uring operations submitted by BlockingRequest.
+std::string OpName(uint8_t opcode) {
+  switch (opcode) {
+    case IORING_OP_NOP:
+      return "nop";
+    case IORING_OP_CONNECT:
+      return "connect";
+    case IORING_OP_ACCEPT:
+      return "accept";
+    case IORING_OP_READ:
+      return "read";
+    case IORING_OP_WRITE:
+      return "write";
+    case IORING_OP_READ_FIXED:
+      return "read_fixed";
+    case IORING_OP_WRITE_FIXED:
+      return "write_fixed";
+    case IORING_OP_SPLICE:
+      return "splice";
+    case IORING_OP_OPENAT:
+      return "openat";
+    case IORING_OP_FSYNC:
+      return "fsync";
+    case IORING_OP_SENDMSG:
+      return "sendmsg";
+    case IORING_OP_RECVMSG:
+      return "recvmsg";
+    case IORING_OP_ASYNC_CANCEL:
+      return "cancel";
+    default:
+      return "op_" + std::to_string(opcode);
+  }
+}
+
+}  // namespace
+
+TaskStats::TaskStats(int reactor_id, std::string name)
+    : reactor_id_{reactor_id}, name_{std::move(name)} {
+  stats::Registry* r = stats::Registry::global();
+  stats::Labels labels{{"reactor", std::to_string(reactor_id_)},
+                       {"task", name_}};
+  r->Register("puddle_task_runs_total",
+              "Number of times tasks were resumed.", labels, &runs);
+  r->Register("puddle_task_run_nanoseconds_total",
+              "Time tasks ran between being resumed and switched out.",
+              labels, &run_ns);
+  r->Register("puddle_task_sched_delay_nanoseconds_total",
+              "Time tasks were ready but waiting to be resumed.", labels,
+              &sched_delay_ns);
+  r->Register("puddle_task_suspensions_total",
+              "Number of times tasks suspended.", labels, &suspensions);
+}
+
+TaskStats::~TaskStats() {
+  stats::Registry* r = stats::Registry::global();
+  r->Unregister(&runs);
+  r->Unregister(&run_ns);
+  r->Unregister(&sched_delay_ns);
+  r->Unregister(&suspensions);
+  for (const auto& op : ops_) {
+    if (op) {
+      r->Unregister(&op->blocked);
+      r->Unregister(&op->blocked_ns);
+    }
+  }
+}
+
+void TaskStats::AddBlocked(uint8_t opcode, std::chrono::nanoseconds blocked) {
+  if (opcode >= IORING_OP_LAST) {
+    return;
+  }
+
+  std::unique_ptr<OpStats>& op = ops_[opcode];
+  if (!op) {
+    op = std::make_unique<OpStats>();
+
+    stats::Registry* r = stats::Registry::global();
+    stats::Labels labels{{"reactor", std::to_string(reactor_id_)},
+                         {"task", name_},
+                         {"op", OpName(opcode)}};
+    r->Register("puddle_task_blocked_total",
+                "Number of times tasks blocked on an I/O operation.", labels,
+                &op->blocked);
+    r->Register("puddle_task_blocked_nanoseconds_total",
+                "Time tasks were blocked on an I/O operation.", labels,
+                &op->blocked_ns);
+  }
+  op->blocked.Inc();
+  op->blocked_ns.Inc(blocked.count());
+}
+
+TaskTracer::TaskTracer(int reactor_id) : reactor_id_{reactor_id} {
+  stats::Registry::global()->Register(
+      "puddle_task_sched_delay_microseconds",
+      "Time tasks were ready but waiting to be resumed.",
+      stats::Labels{{"reactor", std::to_string(reactor_id_)}},
+      &sched_delay_us_);
+
+  std::lock_guard<std::mutex> lock(tracers_mu);
+  tracers.push_back(this);
+}
+
+TaskTracer::~TaskTracer() {
+  stats::Registry::global()->Unregister(&sched_delay_us_);
+
+  std::lock_guard<std::mutex> lock(tracers_mu);
+  tracers.erase(std::remove(tracers.begin(), tracers.end(), this),
+                tracers.end());
+}
+
+void TaskTracer::OnSpawn(Context* context) {
+  events_.Add(NowNs(std::chrono::steady_clock::now()), EventType::kSpawn,
+              context->name(), reinterpret_cast<intptr_t>(context));
+}
+
+void TaskTracer::OnSwitch(Context* prev, Context* next, EventType type) {
+  auto now = std::chrono::steady_clock::now();
+  uint64_t now_ns = NowNs(now);
+  events_.Add(now_ns, type, prev->name(), 0);
+  events_.Add(now_ns, EventType::kResume, next->name(),
+              reinterpret_cast<intptr_t>(next));
+
+  TaskStats* prev_stats = Stats(prev);
+  if (prev->run_tp_ != std::chrono::steady_clock::time_point{}) {
+    prev_stats->runs.Inc();
+    prev_stats->run_ns.Inc(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now -
+                                                             prev->run_tp_)
+            .count());
+  }
+  if (type == EventType::kSuspend) {
+    prev_stats->suspensions.Inc();
+  }
+
+  if (next->ready_tp_ != std::chrono::steady_clock::time_point{}) {
+    auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - next->ready_tp_);
+    Stats(next)->sched_delay_ns.Inc(delay.count());
+    sched_delay_us_.Add(delay.count() / 1000);
+    next->ready_tp_ = {};
+  }
+  next->run_tp_ = now;
+}
+
+void TaskTracer::OnSubmit(int n) {
+  events_.Add(NowNs(std::chrono::steady_clock::now()), EventType::kSubmit,
+              "reactor", n);
+}
+
+void TaskTracer::OnComplete(int result) {
+  events_.Add(NowNs(std::chrono::steady_clock::now()), EventType::kComplete,
+              "reactor", result);
+}
+
+void TaskTracer::OnBlocked(Context* context, uint8_t opcode,
+                           std::chrono::nanoseconds blocked) {
+  Stats(context)->AddBlocked(opcode, blocked);
+}
+
+TaskStats* TaskTracer::Stats(Context* context) {
+  if (context->trace_stats_ != nullptr) {
+    return context->trace_stats_;
+  }
+
+  std::unique_ptr<TaskStats>& stats = stats_[context->name()];
+  if (!stats) {
+    stats = std::make_unique<TaskStats>(reactor_id_, context->name());
+  }
+  context->trace_stats_ = stats.get();
+  return stats.get();
+}
+
+std::vector<Event> EventRing::Snapshot() const {
+  uint64_t end = published_.load(std::memory_order_acquire);
+  uint64_t start = end > kSize ? end - kSize : 0;
+
+  std::vector<Event> events;
+  events.reserve(end - start);
+  for (uint64_t i = start; i != end; ++i) {
+    const Slot& slot = slots_[i % kSize];
+    Event event;
+    event.ts_ns = slot.ts_ns.load(std::memory_order_relaxed);
+    event.type = slot.type.load(std::memory_order_relaxed);
+    uint64_t words[kNameWords];
+    for (size_t j = 0; j != kNameWords; j++) {
+      words[j] = slot.name[j].load(std::memory_order_relaxed);
+    }
+    memcpy(event.name, words, sizeof(event.name));
+    event.arg = slot.arg.load(std::memory_order_relaxed);
+    events.push_back(event);
+  }
+
+  // Discard the oldest events if the writer may have overwritten them while
+  // they were being read, where writing event i overwrites event i - kSize.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  uint64_t claimed = claimed_.load(std::memory_order_relaxed);
+  if (claimed > start + kSize) {
+    uint64_t overwritten = std::min(claimed - kSize - start, end - start);
+    events.erase(events.begin(), events.begin() + overwritten);
+  }
+  return events;
+}
+
+std::string FormatChromeTrace() {
+  fmt::memory_buffer buf;
+  auto out = std::back_inserter(buf);
+  int pid = getpid();
+  bool first = true;
+  auto sep = [&] {
+    if (!first) {
+      fmt::format_to(out, ",\n");
+    }
+    first = false;
+  };
+
+  fmt::format_to(out, "{{\"traceEvents\":[\n");
+
+  std::lock_guard<std::mutex> lock(tracers_mu);
+  for (TaskTracer* tracer : tracers) {
+    int tid = tracer->reactor_id_;
+    sep();
+    fmt::format_to(out,
+                   "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":{},"
+                   "\"tid\":{},\"args\":{{\"name\":\"reactor {}\"}}}}",
+                   pid, tid, tid);
+
+    // The resumed context whose slice ends at the next switch, if any.
+    const Event* resumed = nullptr;
+    for (const Event& event : tracer->events_.Snapshot()) {
+      double ts = event.ts_ns / 1000.0;
+      switch (event.type) {
+        case EventType::kResume:
+          resumed = &event;
+          break;
+        case EventType::kYield:
+        case EventType::kSuspend:
+        case EventType::kTerminate:
+          if (resumed != nullptr) {
+            sep();
+            fmt::format_to(
+                out,
+                "{{\"name\":\"{}\",\"cat\":\"task\",\"ph\":\"X\","
+                "\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":{},\"tid\":{},"
+                "\"args\":{{\"id\":\"{:#x}\",\"end\":\"{}\"}}}}",
+                EscapeJson(event.name), resumed->ts_ns / 1000.0,
+                (event.ts_ns - resumed->ts_ns) / 1000.0, pid, tid,
+                static_cast<uint64_t>(resumed->arg), SwitchName(event.type));
+          }
+          resumed = nullptr;
+          break;
+        case EventType::kSpawn:
+          sep();
+          fmt::format_to(
+              out,
+              "{{\"name\":\"spawn\",\"cat\":\"task\",\"ph\":\"i\","
+              "\"s\":\"t\",\"ts\":{:.3f},\"pid\":{},\"tid\":{},"
+              "\"args\":{{\"id\":\"{:#x}\"}}}}",
+              ts, pid, tid, static_cast<uint64_t>(event.arg));
+          break;
+        case EventType::kSubmit:
+          sep();
+          fmt::format_to(
+              out,
+              "{{\"name\":\"submit\",\"cat\":\"io\",\"ph\":\"i\","
+              "\"s\":\"t\",\"ts\":{:.3f},\"pid\":{},\"tid\":{},"
+              "\"args\":{{\"sqes\":{}}}}}",
+              ts, pid, tid, event.arg);
+          break;
+        case EventType::kComplete:
+          sep();
+          fmt::format_to(
+              out,
+              "{{\"name\":\"complete\",\"cat\":\"io\",\"ph\":\"i\","
+              "\"s\":\"t\",\"ts\":{:.3f},\"pid\":{},\"tid\":{},"
+              "\"args\":{{\"result\":{}}}}}",
+              ts, pid, tid, event.arg);
+          break;
+      }
+    }
+  }
+
+  fmt::format_to(out, "\n]}}\n");
+  return fmt::to_string(buf);
+}
+
+}  // namespace internal
+}  // namespace puddle
+
+#endif  // PUDDLE_TASK_TRACING
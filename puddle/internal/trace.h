@@ -0,0 +1,243 @@
+#pragma once
+
+#include <liburing.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "puddle/stats/local_histogram.h"
+#include "puddle/stats/metrics.h"
+
+namespace puddle {
+namespace internal {
+
+class Context;
+
+// Per-task tracing.
+//
+// When built with PUDDLE_TASK_TRACING defined, each reactor accounts for how
+// its tasks spend their time, aggregated by task name (see
+// puddle::SetTaskName):
+// * Scheduling delay: Time between a task being added to the ready queue and
+// resuming
+// * Run time: Time the task runs between being resumed and switched out
+// * Suspensions: Number of times the task suspended
+// * Blocked time: Time the task is blocked in a BlockingRequest, by io_uring
+// operation
+//
+// The aggregates are registered with the global stats::Registry, labelled by
+// reactor and task name, so are exported with the other runtime metrics.
+//
+// Each reactor also records recent runtime events (tasks spawning, resuming
+// and switching out, and io_uring submissions and completions) to a ring
+// buffer, which FormatChromeTrace exports as a timeline.
+//
+// Tracing reads the clock on every context switch, so is compiled out
+// entirely unless enabled. PUDDLE_TASK_TRACING must be defined for the whole
+// build (such as with --copt=-DPUDDLE_TASK_TRACING), as it changes the
+// layout of Context.
+
+#ifdef PUDDLE_TASK_TRACING
+
+// Aggregated trace of all tasks with the same name on a reactor.
+class TaskStats {
+ public:
+  TaskStats(int reactor_id, std::string name);
+
+  ~TaskStats();
+
+  TaskStats(const TaskStats& s) = delete;
+  TaskStats& operator=(const TaskStats& s) = delete;
+
+  TaskStats(TaskStats&& s) = delete;
+  TaskStats& operator=(TaskStats&& s) = delete;
+
+  void AddBlocked(uint8_t opcode, std::chrono::nanoseconds blocked);
+
+  stats::Counter runs;
+
+  stats::Counter run_ns;
+
+  stats::Counter sched_delay_ns;
+
+  stats::Counter suspensions;
+
+ private:
+  struct OpStats {
+    stats::Counter blocked;
+
+    stats::Counter blocked_ns;
+  };
+
+  int reactor_id_;
+
+  std::string name_;
+
+  // Blocked time indexed by io_uring opcode, created on first use.
+  std::unique_ptr<OpStats> ops_[IORING_OP_LAST];
+};
+
+enum class EventType : uint8_t {
+  // Context spawned, where arg is the context ID.
+  kSpawn,
+  // Context resumed, where arg is the context ID.
+  kResume,
+  // Context yielded.
+  kYield,
+  // Context suspended.
+  kSuspend,
+  // Context terminated.
+  kTerminate,
+  // Entries submitted to io_uring, where arg is the number of entries.
+  kSubmit,
+  // io_uring operation completed, where arg is the result.
+  kComplete,
+};
+
+struct Event {
+  // Size of the name buffer, including the terminating null.
+  static constexpr size_t kNameSize = 32;
+
+  // Time of the event in nanoseconds (from the steady clock).
+  uint64_t ts_ns;
+
+  EventType type;
+
+  // Name of the active context, truncated to kNameSize - 1 bytes. The name
+  // is copied as events outlive the context.
+  char name[kNameSize];
+
+  int64_t arg;
+};
+
+// Ring buffer of the most recent events on a reactor.
+//
+// Only the reactor thread adds events, which overwrite the oldest events once
+// the ring is full, though events may be read from any thread.
+class EventRing {
+ public:
+  static constexpr size_t kSize = 1 << 14;
+
+  EventRing() : slots_{std::make_unique<Slot[]>(kSize)} {}
+
+  EventRing(const EventRing& r) = delete;
+  EventRing& operator=(const EventRing& r) = delete;
+
+  EventRing(EventRing&& r) = delete;
+  EventRing& operator=(EventRing&& r) = delete;
+
+  void Add(uint64_t ts_ns, EventType type, const char* name, int64_t arg) {
+    // Claim the slot before writing so concurrent readers can discard events
+    // that are overwritten while being read.
+    uint64_t index = published_.load(std::memory_order_relaxed);
+    claimed_.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Slot& slot = slots_[index % kSize];
+    slot.ts_ns.store(ts_ns, std::memory_order_relaxed);
+    slot.type.store(type, std::memory_order_relaxed);
+    uint64_t words[kNameWords] = {};
+    memcpy(words, name, strnlen(name, Event::kNameSize - 1));
+    for (size_t i = 0; i != kNameWords; i++) {
+      slot.name[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.arg.store(arg, std::memory_order_relaxed);
+
+    published_.store(index + 1, std::memory_order_release);
+  }
+
+  // Returns the events in the ring, oldest first.
+  std::vector<Event> Snapshot() const;
+
+ private:
+  static constexpr size_t kNameWords = Event::kNameSize / sizeof(uint64_t);
+
+  // Fields are relaxed atomics so readers can race with the reactor thread.
+  struct Slot {
+    std::atomic<uint64_t> ts_ns;
+
+    std::atomic<EventType> type;
+
+    // Null padded name.
+    std::atomic<uint64_t> name[kNameWords];
+
+    std::atomic<int64_t> arg;
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+
+  // Number of events claimed by the writer, which may be ahead of published_
+  // while an event is being written.
+  std::atomic<uint64_t> claimed_{0};
+
+  // Number of events written.
+  std::atomic<uint64_t> published_{0};
+};
+
+// Traces the tasks on a reactor. The scheduler records when each context is
+// added to the ready queue.
+class TaskTracer {
+ public:
+  explicit TaskTracer(int reactor_id);
+
+  ~TaskTracer();
+
+  TaskTracer(const TaskTracer& t) = delete;
+  TaskTracer& operator=(const TaskTracer& t) = delete;
+
+  TaskTracer(TaskTracer&& t) = delete;
+  TaskTracer& operator=(TaskTracer&& t) = delete;
+
+  // Records the context was spawned.
+  void OnSpawn(Context* context);
+
+  // Records switching from prev to next, where type is the reason prev was
+  // switched out (kYield, kSuspend or kTerminate).
+  void OnSwitch(Context* prev, Context* next, EventType type);
+
+  // Records n entries were submitted to io_uring.
+  void OnSubmit(int n);
+
+  // Records an io_uring operation completed with the given result.
+  void OnComplete(int result);
+
+  // Records the context was blocked waiting for the io_uring operation with
+  // the given opcode.
+  void OnBlocked(Context* context, uint8_t opcode,
+                 std::chrono::nanoseconds blocked);
+
+ private:
+  // Returns the stats for the contexts name.
+  TaskStats* Stats(Context* context);
+
+  int reactor_id_;
+
+  std::unordered_map<std::string, std::unique_ptr<TaskStats>> stats_;
+
+  // Scheduling delay of all tasks in microseconds.
+  stats::LocalHistogram sched_delay_us_;
+
+  EventRing events_;
+
+  // Required to read the events of all reactors.
+  friend std::string FormatChromeTrace();
+};
+
+// Formats the recent events of all reactors in the Chrome trace event JSON
+// format, which can be opened with Perfetto (https://ui.perfetto.dev) or
+// chrome://tracing.
+//
+// Each reactor is shown as a thread, with a slice each time a task runs, and
+// instant events for spawns and io_uring submissions and completions.
+std::string FormatChromeTrace();
+
+#endif  // PUDDLE_TASK_TRACING
+
+}  // namespace internal
+}  // namespace puddle
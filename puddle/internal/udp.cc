@@ -0,0 +1,318 @@
+#include "puddle/internal/udp.h"
+
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+namespace puddle {
+namespace internal {
+
+UdpSocket::UdpSocket(int socket) : socket_{socket} {}
+
+UdpSocket::~UdpSocket() {
+  if (socket_ != -1) {
+    close(socket_);
+  }
+}
+
+UdpSocket::UdpSocket(UdpSocket&& s) {
+  socket_ = s.socket_;
+  s.socket_ = -1;
+}
+
+UdpSocket& UdpSocket::operator=(UdpSocket&& s) {
+  std::swap(socket_, s.socket_);
+  return *this;
+}
+
+void UdpSocket::Bind(const SocketAddr& addr) {
+  if (addr.family() == AF_INET6) {
+    // Receive IPv4 datagrams (as IPv4-mapped IPv6 addresses) regardless of
+    // the net.ipv6.bindv6only default.
+    int opt = 0;
+    if (setsockopt(socket_, IPPROTO_IPV6, IPV6_V6ONLY, &opt, sizeof(opt)) ==
+        -1) {
+      throw std::system_error(errno, std::system_category(), "socket option");
+    }
+  }
+
+  if (bind(socket_, addr.addr(), addr.len) == -1) {
+    throw std::system_error(errno, std::system_category(), "socket bind");
+  }
+}
+
+void UdpSocket::EnableGro() {
+  int opt = 1;
+  if (setsockopt(socket_, SOL_UDP, UDP_GRO, &opt, sizeof(opt)) == -1) {
+    throw std::system_error(errno, std::system_category(), "socket option");
+  }
+}
+
+size_t UdpSocket::RecvFrom(uint8_t* buf, size_t size, SocketAddr* addr) {
+  struct iovec iov {
+    buf, size
+  };
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &addr->storage;
+  msg.msg_namelen = sizeof(addr->storage);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  BlockingRequest r;
+  r.RecvMsg(socket_, &msg, 0);
+  int read_n = r.Wait();
+  if (read_n < 0) {
+    throw std::system_error(-read_n, std::system_category(), "socket recv");
+  }
+  addr->len = msg.msg_namelen;
+  return read_n;
+}
+
+size_t UdpSocket::SendTo(const uint8_t* buf, size_t size,
+                         const SocketAddr& addr) {
+  struct iovec iov {
+    const_cast<uint8_t*>(buf), size
+  };
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = const_cast<struct sockaddr_storage*>(&addr.storage);
+  msg.msg_namelen = addr.len;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  BlockingRequest r;
+  r.SendMsg(socket_, &msg, 0);
+  int write_n = r.Wait();
+  if (write_n < 0) {
+    throw std::system_error(-write_n, std::system_category(), "socket send");
+  }
+  return write_n;
+}
+
+size_t UdpSocket::SendSegmented(const uint8_t* buf, size_t size,
+                                uint16_t segment_size, const SocketAddr& addr) {
+  struct iovec iov {
+    const_cast<uint8_t*>(buf), size
+  };
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = const_cast<struct sockaddr_storage*>(&addr.storage);
+  msg.msg_namelen = addr.len;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  // Set the segment size with a UDP_SEGMENT control message.
+  alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))];
+  memset(control, 0, sizeof(control));
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_UDP;
+  cmsg->cmsg_type = UDP_SEGMENT;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+  memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+
+  BlockingRequest r;
+  r.SendMsg(socket_, &msg, 0);
+  int write_n = r.Wait();
+  if (write_n < 0) {
+    throw std::system_error(-write_n, std::system_category(), "socket send");
+  }
+  return write_n;
+}
+
+UdpSocket UdpSocket::Open(int family) {
+  int s = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (s == -1) {
+    throw std::system_error(errno, std::system_category(), "socket open");
+  }
+  return UdpSocket{s};
+}
+
+MultishotRecv::MultishotRecv(int fd, size_t buffer_size, unsigned buffers)
+    : fd_{fd},
+      buffer_size_{buffer_size},
+      buffers_{buffers},
+      buf_(buffer_size * buffers),
+      armed_{false},
+      error_{0},
+      waiter_{nullptr} {
+  int err;
+  buf_ring_ = Reactor::local()->SetupBufRing(buffers_, &bgid_, &err);
+  if (buf_ring_ == nullptr) {
+    throw std::system_error(-err, std::system_category(), "setup buf ring");
+  }
+
+  // Add all buffers to the ring.
+  for (unsigned i = 0; i != buffers_; i++) {
+    io_uring_buf_ring_add(buf_ring_, buf_.data() + i * buffer_size_,
+                          buffer_size_, i, io_uring_buf_ring_mask(buffers_),
+                          i);
+  }
+  io_uring_buf_ring_advance(buf_ring_, buffers_);
+
+  // Reserve space for the source address and a UDP_GRO control message in
+  // each buffer.
+  memset(&msg_, 0, sizeof(msg_));
+  msg_.msg_namelen = sizeof(struct sockaddr_storage);
+  msg_.msg_controllen = CMSG_SPACE(sizeof(int));
+}
+
+MultishotRecv::~MultishotRecv() {
+  if (armed_) {
+    BlockingRequest r;
+    r.Cancel(this);
+    r.Wait();
+
+    // Wait for the final completion of the recvmsg, which has
+    // IORING_CQE_F_MORE unset.
+    while (armed_) {
+      waiter_ = Reactor::local()->active();
+      Reactor::local()->Suspend();
+    }
+  }
+  Reactor::local()->FreeBufRing(buf_ring_, buffers_, bgid_);
+}
+
+void MultishotRecv::Recv(std::vector<Datagram>* datagrams) {
+  datagrams->clear();
+  Recycle();
+
+  if (error_ != 0) {
+    // Report the error from a previous batch that also had datagrams.
+    int err = error_;
+    error_ = 0;
+    throw std::system_error(err, std::system_category(), "socket recv");
+  }
+
+  while (datagrams->empty()) {
+    if (completed_.empty()) {
+      if (!armed_) {
+        Arm();
+      }
+      waiter_ = Reactor::local()->active();
+      Reactor::local()->Suspend();
+    }
+
+    // Process the whole batch before reporting an error, so every selected
+    // buffer is recycled and no received datagrams are dropped.
+    int err = 0;
+    std::vector<std::pair<int, uint32_t>> completed;
+    completed.swap(completed_);
+    for (const auto& c : completed) {
+      int result = c.first;
+      uint32_t flags = c.second;
+
+      if (result == -ENOBUFS) {
+        // All buffers are in use, so the multishot recvmsg has been
+        // terminated. It will be re-armed after the buffers are recycled.
+        continue;
+      }
+      if ((flags & IORING_CQE_F_BUFFER) != 0) {
+        used_.push_back(flags >> IORING_CQE_BUFFER_SHIFT);
+      }
+      if (result < 0) {
+        if (err == 0) {
+          err = -result;
+        }
+        continue;
+      }
+      if ((flags & IORING_CQE_F_BUFFER) != 0) {
+        AddDatagrams(used_.back(), result, datagrams);
+      }
+    }
+    if (err != 0) {
+      if (datagrams->empty()) {
+        throw std::system_error(err, std::system_category(), "socket recv");
+      }
+      // Return the datagrams, then report the error on the next call.
+      error_ = err;
+      return;
+    }
+
+    if (datagrams->empty()) {
+      // If there were no datagrams, buffers may be exhausted so recycle
+      // before waiting again.
+      Recycle();
+    }
+  }
+}
+
+void MultishotRecv::Complete(int result, uint32_t flags) {
+  completed_.emplace_back(result, flags);
+  if ((flags & IORING_CQE_F_MORE) == 0) {
+    armed_ = false;
+  }
+
+  if (waiter_ != nullptr) {
+    Reactor::local()->Schedule(waiter_);
+    waiter_ = nullptr;
+  }
+}
+
+void MultishotRecv::Arm() {
+  struct io_uring_sqe* sqe = Reactor::local()->GetSqe(this);
+  io_uring_prep_recvmsg_multishot(sqe, fd_, &msg_, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = bgid_;
+  armed_ = true;
+}
+
+void MultishotRecv::Recycle() {
+  int mask = io_uring_buf_ring_mask(buffers_);
+  for (size_t i = 0; i != used_.size(); i++) {
+    io_uring_buf_ring_add(buf_ring_, buf_.data() + used_[i] * buffer_size_,
+                          buffer_size_, used_[i], mask, i);
+  }
+  io_uring_buf_ring_advance(buf_ring_, used_.size());
+  used_.clear();
+}
+
+void MultishotRecv::AddDatagrams(uint16_t bid, int len,
+                                 std::vector<Datagram>* datagrams) {
+  uint8_t* buf = buf_.data() + bid * buffer_size_;
+  struct io_uring_recvmsg_out* out =
+      io_uring_recvmsg_validate(buf, len, &msg_);
+  if (out == nullptr) {
+    return;
+  }
+
+  SocketAddr addr;
+  addr.len = std::min<socklen_t>(out->namelen, sizeof(addr.storage));
+  memcpy(&addr.storage, io_uring_recvmsg_name(out), addr.len);
+
+  // If the kernel coalesced datagrams with generic receive offload, the
+  // UDP_GRO control message contains the size of each datagram.
+  size_t segment_size = 0;
+  for (struct cmsghdr* cmsg = io_uring_recvmsg_cmsg_firsthdr(out, &msg_);
+       cmsg != nullptr;
+       cmsg = io_uring_recvmsg_cmsg_nexthdr(out, &msg_, cmsg)) {
+    if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+      int gso_size;
+      memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+      segment_size = gso_size;
+    }
+  }
+
+  const uint8_t* payload =
+      static_cast<const uint8_t*>(io_uring_recvmsg_payload(out, &msg_));
+  size_t payload_len = io_uring_recvmsg_payload_length(out, len, &msg_);
+  if (segment_size == 0) {
+    segment_size = payload_len;
+  }
+
+  size_t offset = 0;
+  do {
+    size_t size = std::min(segment_size, payload_len - offset);
+    datagrams->push_back(Datagram{payload + offset, size, addr});
+    offset += size;
+  } while (offset < payload_len);
+}
+
+}  // namespace internal
+}  // namespace puddle
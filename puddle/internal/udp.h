@@ -0,0 +1,136 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "puddle/internal/addr.h"
+#include "puddle/internal/reactor.h"
+
+namespace puddle {
+namespace internal {
+
+class UdpSocket {
+ public:
+  UdpSocket(int socket = -1);
+
+  ~UdpSocket();
+
+  UdpSocket(const UdpSocket& s) = delete;
+  UdpSocket& operator=(const UdpSocket& s) = delete;
+
+  UdpSocket(UdpSocket&& s);
+  UdpSocket& operator=(UdpSocket&& s);
+
+  int fd() const { return socket_; }
+
+  void Bind(const SocketAddr& addr);
+
+  // Enables UDP generic receive offload, where the kernel may coalesce
+  // datagrams from the same sender into a single receive.
+  void EnableGro();
+
+  size_t RecvFrom(uint8_t* buf, size_t size, SocketAddr* addr);
+
+  size_t SendTo(const uint8_t* buf, size_t size, const SocketAddr& addr);
+
+  // Sends the buffer as datagrams of segment_size bytes (where the last
+  // datagram may be smaller) with a single send, using UDP generic
+  // segmentation offload.
+  size_t SendSegmented(const uint8_t* buf, size_t size, uint16_t segment_size,
+                       const SocketAddr& addr);
+
+  static UdpSocket Open(int family);
+
+ private:
+  int socket_ = -1;
+};
+
+// Datagram is a datagram received by MultishotRecv.
+struct Datagram {
+  // Points to the datagram payload in a provided buffer.
+  const uint8_t* data;
+
+  size_t size;
+
+  SocketAddr addr;
+};
+
+// MultishotRecv receives datagrams using a multishot recvmsg, where the
+// kernel selects a buffer from a ring of provided buffers for each datagram.
+// This means a single request can receive many datagrams, and a batch of
+// datagrams can be processed each time the receiving task is woken.
+//
+// If generic receive offload is enabled, coalesced datagrams are split into
+// the original datagrams.
+class MultishotRecv final : public Completion {
+ public:
+  // Receives from the socket fd into the given number of buffers (which must
+  // be a power of 2) of buffer_size bytes.
+  MultishotRecv(int fd, size_t buffer_size, unsigned buffers);
+
+  // Cancels the multishot recvmsg and waits for it to complete.
+  ~MultishotRecv();
+
+  MultishotRecv(const MultishotRecv& r) = delete;
+  MultishotRecv& operator=(const MultishotRecv& r) = delete;
+
+  MultishotRecv(MultishotRecv&& r) = delete;
+  MultishotRecv& operator=(MultishotRecv&& r) = delete;
+
+  // Blocks until at least one datagram is received, then sets datagrams to
+  // all received datagrams. If a receive fails, any datagrams received with
+  // it are returned first, and the error is thrown by the next call.
+  //
+  // The datagrams point to the provided buffers, so are only valid until the
+  // next call to Recv.
+  void Recv(std::vector<Datagram>* datagrams);
+
+  void Complete(int result, uint32_t flags) override;
+
+ private:
+  // Submits the multishot recvmsg.
+  void Arm();
+
+  // Returns the buffers used by the previous Recv to the buffer ring.
+  void Recycle();
+
+  // Adds the datagrams in the buffer with the given ID and length.
+  void AddDatagrams(uint16_t bid, int len, std::vector<Datagram>* datagrams);
+
+  int fd_;
+
+  size_t buffer_size_;
+
+  unsigned buffers_;
+
+  std::vector<uint8_t> buf_;
+
+  struct io_uring_buf_ring* buf_ring_;
+
+  int bgid_;
+
+  // Describes the address and control space to reserve in each buffer.
+  struct msghdr msg_;
+
+  // Whether the multishot recvmsg is active.
+  bool armed_;
+
+  // Completions (result and flags) not yet processed by Recv.
+  std::vector<std::pair<int, uint32_t>> completed_;
+
+  // Error (errno) to throw from the next Recv, or 0.
+  int error_;
+
+  // IDs of buffers used by the previous Recv.
+  std::vector<uint16_t> used_;
+
+  // Context waiting in Recv for a completion, or nullptr.
+  Context* waiter_;
+};
+
+}  // namespace internal
+}  // namespace puddle
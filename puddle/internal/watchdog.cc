@@ -0,0 +1,259 @@
+#include "puddle/internal/watchdog.h"
+
+#include <execinfo.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include "puddle/internal/reactor.h"
+#include "puddle/log/rate_limit.h"
+
+namespace puddle {
+namespace internal {
+
+namespace {
+
+constexpr int kMaxFrames = 64;
+
+// Time to wait for the stalled thread to handle the capture signal.
+constexpr std::chrono::milliseconds kCaptureTimeout{100};
+
+constexpr size_t kMaxTaskName = 32;
+
+// Backtrace captured by the signal handler on the stalled thread. Only the
+// watchdog thread requests captures, so there is at most one in progress.
+struct Capture {
+  // Sequence number of the requested capture, set by the watchdog and
+  // cleared by the handler that claims it, or 0 if there is no request. This
+  // ignores signals that arrive after the watchdog gives up waiting.
+  std::atomic<uint64_t> requested{0};
+
+  // Reactor whose thread should capture its backtrace.
+  std::atomic<Reactor*> reactor{nullptr};
+
+  // Sequence number of the last completed capture, set by the handler.
+  std::atomic<uint64_t> done{0};
+
+  void* frames[kMaxFrames];
+
+  int size;
+
+  // Name of the stalled task, copied as the task may exit before the stall is
+  // logged.
+  char task[kMaxTaskName];
+};
+
+Capture capture;
+
+std::mutex global_mu;
+
+Watchdog* global_watchdog = nullptr;
+
+void CaptureHandler(int) {
+  int saved_errno = errno;
+
+  // Only claim the request on the requested reactor's thread, so a late
+  // signal for an earlier request doesn't capture the wrong thread.
+  Reactor* reactor = Reactor::local();
+  uint64_t seq = capture.requested.load(std::memory_order_acquire);
+  if (seq != 0 && reactor != nullptr &&
+      capture.reactor.load(std::memory_order_relaxed) == reactor &&
+      capture.requested.compare_exchange_strong(seq, 0)) {
+    capture.size = backtrace(capture.frames, kMaxFrames);
+    const char* task = reactor->active()->name();
+    size_t n = strnlen(task, kMaxTaskName - 1);
+    memcpy(capture.task, task, n);
+    capture.task[n] = '\0';
+    capture.done.store(seq, std::memory_order_release);
+  }
+
+  errno = saved_errno;
+}
+
+std::string FormatBacktrace() {
+  // Skip the signal handler frame.
+  if (capture.size <= 1) {
+    return "";
+  }
+  char** symbols = backtrace_symbols(capture.frames + 1, capture.size - 1);
+  if (symbols == nullptr) {
+    return "";
+  }
+
+  std::string s;
+  for (int i = 0; i != capture.size - 1; ++i) {
+    s += "\n  ";
+    s += symbols[i];
+  }
+  free(symbols);
+  return s;
+}
+
+}  // namespace
+
+Watchdog::Config Watchdog::Config::Default() {
+  Config config;
+  config.threshold = std::chrono::milliseconds{100};
+  config.signal = SIGURG;
+  return config;
+}
+
+void Watchdog::Add(Reactor* reactor) {
+  std::lock_guard<std::mutex> lock(mu_);
+  watched_.push_back(Watched{reactor, pthread_self(), reactor->loop_epoch(),
+                             std::chrono::steady_clock::now(), false});
+}
+
+void Watchdog::Remove(Reactor* reactor) {
+  std::lock_guard<std::mutex> lock(mu_);
+  watched_.erase(std::remove_if(watched_.begin(), watched_.end(),
+                                [reactor](const Watched& w) {
+                                  return w.reactor == reactor;
+                                }),
+                 watched_.end());
+}
+
+void Watchdog::Start(Config config) {
+  std::lock_guard<std::mutex> lock(global_mu);
+  if (global_watchdog != nullptr) {
+    return;
+  }
+
+  // backtrace loads libgcc on first use, which isn't safe in a signal
+  // handler, so load it now.
+  void* frames[1];
+  backtrace(frames, 1);
+
+  struct sigaction action = {};
+  action.sa_handler = CaptureHandler;
+  // Restart interrupted syscalls, as the stalled thread may be blocked in a
+  // syscall.
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(config.signal, &action, nullptr) == -1) {
+    throw std::system_error(errno, std::system_category(), "sigaction");
+  }
+
+  // The watchdog runs for the lifetime of the process.
+  global_watchdog = new Watchdog{config};
+}
+
+Watchdog* Watchdog::global() {
+  std::lock_guard<std::mutex> lock(global_mu);
+  return global_watchdog;
+}
+
+Watchdog::Watchdog(Config config) : config_{config}, logger_{"watchdog"} {
+  thread_ = std::thread{&Watchdog::Run, this};
+}
+
+void Watchdog::Run() {
+  // Check a few times per threshold, so stalls are reported within 1.25x
+  // the threshold.
+  auto interval =
+      std::max(config_.threshold / 4, std::chrono::milliseconds{1});
+  while (true) {
+    std::this_thread::sleep_for(interval);
+
+    // Report stalls after releasing the lock, as capturing a backtrace may
+    // wait for the capture timeout, which would block Add and Remove.
+    std::vector<Stall> stalls;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      auto now = std::chrono::steady_clock::now();
+      for (Watched& watched : watched_) {
+        uint64_t epoch = watched.reactor->loop_epoch();
+        if (epoch != watched.epoch) {
+          watched.epoch = epoch;
+          watched.since = now;
+          watched.reported = false;
+          continue;
+        }
+
+        // An even epoch means the reactor is in its event loop (which
+        // includes waiting for I/O) so isn't stalled.
+        if (epoch % 2 == 0 || watched.reported) {
+          continue;
+        }
+
+        auto stalled = std::chrono::duration_cast<std::chrono::milliseconds>(
+            now - watched.since);
+        if (stalled >= config_.threshold) {
+          watched.reported = true;
+          stalls.push_back(Stall{watched.reactor, watched.thread,
+                                 watched.reactor->id(), stalled});
+        }
+      }
+    }
+
+    for (const Stall& stall : stalls) {
+      Report(stall);
+    }
+  }
+}
+
+void Watchdog::Report(const Stall& stall) {
+  uint64_t seq = ++capture_seq_;
+  capture.reactor.store(stall.reactor, std::memory_order_relaxed);
+  capture.requested.store(seq, std::memory_order_release);
+
+  bool captured = false;
+  if (Signal(stall)) {
+    auto deadline = std::chrono::steady_clock::now() + kCaptureTimeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+      if (capture.done.load(std::memory_order_acquire) == seq) {
+        captured = true;
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+  }
+
+  if (!captured) {
+    uint64_t expected = seq;
+    if (!capture.requested.compare_exchange_strong(expected, 0)) {
+      // The handler claimed the request after the timeout, so wait for it to
+      // finish rather than racing with the next capture.
+      while (capture.done.load(std::memory_order_acquire) != seq) {
+        std::this_thread::yield();
+      }
+      captured = true;
+    }
+  }
+
+  if (!captured) {
+    PUDDLE_LOG_RATE_LIMITED(
+        logger_, log::Level::kWarn, 1, 5,
+        "reactor stalled; reactor = {}, stalled = {}ms, backtrace = unknown",
+        stall.reactor_id, stall.stalled.count());
+    return;
+  }
+
+  PUDDLE_LOG_RATE_LIMITED(
+      logger_, log::Level::kWarn, 1, 5,
+      "reactor stalled; reactor = {}, stalled = {}ms, task = {}, backtrace ={}",
+      stall.reactor_id, stall.stalled.count(), capture.task,
+      FormatBacktrace());
+}
+
+bool Watchdog::Signal(const Stall& stall) {
+  // Hold the lock so the reactor thread can't exit (which removes the
+  // reactor first) while being signalled.
+  std::lock_guard<std::mutex> lock(mu_);
+  for (const Watched& watched : watched_) {
+    if (watched.reactor == stall.reactor &&
+        pthread_equal(watched.thread, stall.thread)) {
+      return pthread_kill(watched.thread, config_.signal) == 0;
+    }
+  }
+  return false;
+}
+
+}  // namespace internal
+}  // namespace puddle
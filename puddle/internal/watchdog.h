@@ -0,0 +1,116 @@
+#pragma once
+
+#include <pthread.h>
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "puddle/log/log.h"
+
+namespace puddle {
+namespace internal {
+
+class Reactor;
+
+// Watchdog detects tasks that stall their reactor.
+//
+// Tasks are cooperatively scheduled, so a task that runs a long CPU loop or
+// makes a blocking syscall without yielding stalls every other task on the
+// reactor. The watchdog thread periodically checks each reactor has returned
+// to its event loop (see Reactor::loop_epoch). If a reactor has been running
+// tasks for longer than the threshold, the watchdog signals the reactor
+// thread to capture the backtrace of the stalled task, then logs it along
+// with the task name.
+//
+// Stall reports are rate limited, and each stall is reported at most once.
+class Watchdog {
+ public:
+  struct Config {
+    // Time a reactor may run tasks without returning to its event loop
+    // before it is considered stalled.
+    std::chrono::milliseconds threshold;
+
+    // Signal used to capture the backtrace of a stalled reactor thread.
+    int signal;
+
+    static Config Default();
+  };
+
+  Watchdog(const Watchdog& w) = delete;
+  Watchdog& operator=(const Watchdog& w) = delete;
+
+  Watchdog(Watchdog&& w) = delete;
+  Watchdog& operator=(Watchdog&& w) = delete;
+
+  // Watches the reactor, which must be running on the calling thread.
+  void Add(Reactor* reactor);
+
+  // Stops watching the reactor.
+  void Remove(Reactor* reactor);
+
+  // Starts the global watchdog, which runs for the lifetime of the process.
+  // Has no effect if the watchdog is already started.
+  static void Start(Config config = Config::Default());
+
+  // Returns the global watchdog, or nullptr if it is not started.
+  static Watchdog* global();
+
+ private:
+  struct Watched {
+    Reactor* reactor;
+
+    pthread_t thread;
+
+    // Loop epoch when last checked.
+    uint64_t epoch;
+
+    // Time the epoch was first seen.
+    std::chrono::steady_clock::time_point since;
+
+    // Whether the stall at epoch has been reported.
+    bool reported;
+  };
+
+  // Stall found by Run, which is reported after releasing mu_.
+  struct Stall {
+    Reactor* reactor;
+
+    pthread_t thread;
+
+    int reactor_id;
+
+    std::chrono::milliseconds stalled;
+  };
+
+  explicit Watchdog(Config config);
+
+  void Run();
+
+  // Signals the stalled reactor thread to capture its backtrace, then logs
+  // the stall. Must be called without holding mu_.
+  void Report(const Stall& stall);
+
+  // Signals the reactor thread if the reactor is still watched. Returns
+  // whether the signal was sent.
+  bool Signal(const Stall& stall);
+
+  Config config_;
+
+  std::mutex mu_;
+
+  std::vector<Watched> watched_;
+
+  // Sequence number of the last capture request. Only accessed by the
+  // watchdog thread.
+  uint64_t capture_seq_ = 0;
+
+  std::thread thread_;
+
+  log::Logger logger_;
+};
+
+}  // namespace internal
+}  // namespace puddle
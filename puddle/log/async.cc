@@ -0,0 +1,308 @@
+#include "puddle/log/async.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "fmt/core.h"
+
+namespace puddle {
+namespace log {
+
+namespace {
+
+struct RecordHeader {
+  FILE* file;
+  // Function to format the record, or nullptr if the record is already
+  // formatted.
+  AsyncWriter::FormatFn format;
+  uint32_t size;
+};
+
+std::atomic<uint64_t> next_writer_id{1};
+
+std::mutex global_mu;
+
+}  // namespace
+
+class AsyncWriter::Ring {
+ public:
+  explicit Ring(size_t size)
+      : buf_{new uint8_t[size]}, size_{size}, head_{0}, tail_{0}, dropped_{0} {}
+
+  // Appends the record. Returns the number of used bytes after appending, or
+  // 0 if the record was dropped as the buffer is full. Must only be called by
+  // the owning thread.
+  size_t Push(FILE* file, AsyncWriter::FormatFn format,
+              std::string_view record) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+
+    size_t needed = sizeof(RecordHeader) + record.size();
+    if (needed > size_ - (head - tail)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return 0;
+    }
+
+    RecordHeader header{file, format, static_cast<uint32_t>(record.size())};
+    CopyIn(head, &header, sizeof(header));
+    CopyIn(head + sizeof(header), record.data(), record.size());
+
+    head_.store(head + needed, std::memory_order_release);
+    return head + needed - tail;
+  }
+
+  // Passes each record header and data to fn. Records that wrap around the
+  // buffer are copied to scratch so the data is contiguous. Must only be
+  // called by one consumer at a time.
+  template <typename Fn>
+  void Pop(std::string* scratch, Fn&& fn) {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail != head) {
+      RecordHeader header;
+      CopyOut(tail, &header, sizeof(header));
+      tail += sizeof(header);
+
+      size_t offset = tail & (size_ - 1);
+      if (offset + header.size <= size_) {
+        fn(header, reinterpret_cast<const char*>(buf_.get() + offset));
+      } else {
+        scratch->resize(header.size);
+        CopyOut(tail, scratch->data(), header.size);
+        fn(header, scratch->data());
+      }
+      tail += header.size;
+    }
+    tail_.store(tail, std::memory_order_release);
+  }
+
+  // Returns the number of dropped records since the last call.
+  uint64_t TakeDropped() {
+    return dropped_.exchange(0, std::memory_order_relaxed);
+  }
+
+  // Marks the ring as released by its producer, which won't push again.
+  void Release() { released_.store(true, std::memory_order_release); }
+
+  // Returns whether the producer released the ring. If so, every record has
+  // been pushed, so the ring is empty once popped.
+  bool released() const { return released_.load(std::memory_order_acquire); }
+
+ private:
+  void CopyIn(uint64_t pos, const void* data, size_t size) {
+    size_t offset = pos & (size_ - 1);
+    size_t n = std::min(size, size_ - offset);
+    memcpy(buf_.get() + offset, data, n);
+    memcpy(buf_.get(), static_cast<const uint8_t*>(data) + n, size - n);
+  }
+
+  void CopyOut(uint64_t pos, void* data, size_t size) {
+    size_t offset = pos & (size_ - 1);
+    size_t n = std::min(size, size_ - offset);
+    memcpy(data, buf_.get() + offset, n);
+    memcpy(static_cast<uint8_t*>(data) + n, buf_.get(), size - n);
+  }
+
+  std::unique_ptr<uint8_t[]> buf_;
+
+  size_t size_;
+
+  // Position to write the next record, written by the producer. Positions
+  // increase monotonically and are masked to get the buffer offset.
+  alignas(64) std::atomic<uint64_t> head_;
+
+  // Position of the first unread record, written by the consumer.
+  alignas(64) std::atomic<uint64_t> tail_;
+
+  std::atomic<uint64_t> dropped_;
+
+  std::atomic<bool> released_{false};
+};
+
+struct AsyncWriter::ThreadRing {
+  ~ThreadRing() { Release(); }
+
+  void Release() {
+    if (ring != nullptr) {
+      ring->Release();
+      ring.reset();
+    }
+    writer_id = 0;
+  }
+
+  uint64_t writer_id = 0;
+
+  std::shared_ptr<Ring> ring;
+};
+
+thread_local AsyncWriter::ThreadRing AsyncWriter::local_ring_;
+
+std::atomic<AsyncWriter*> AsyncWriter::global_{nullptr};
+
+AsyncWriter::Config AsyncWriter::Config::Default() {
+  Config config;
+  config.buffer_size = 1 << 20;
+  config.flush_interval = std::chrono::milliseconds{10};
+  return config;
+}
+
+AsyncWriter::AsyncWriter(Config config)
+    : config_{config},
+      id_{next_writer_id.fetch_add(1, std::memory_order_relaxed)},
+      stopped_{false} {
+  if ((config_.buffer_size & (config_.buffer_size - 1)) != 0) {
+    throw std::invalid_argument("log buffer size must be a power of 2");
+  }
+  thread_ = std::thread{&AsyncWriter::Run, this};
+}
+
+AsyncWriter::~AsyncWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopped_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+
+  Flush();
+}
+
+void AsyncWriter::Write(FILE* file, std::string_view record) {
+  Write(file, nullptr, record);
+}
+
+void AsyncWriter::Write(FILE* file, FormatFn format, std::string_view data) {
+  size_t used = LocalRing()->Push(file, format, data);
+  // Wake the writer early if the buffer is filling up, rather than waiting
+  // for the flush interval and dropping records.
+  if (used > config_.buffer_size / 2) {
+    cv_.notify_one();
+  }
+}
+
+void AsyncWriter::Flush() {
+  std::lock_guard<std::mutex> lock(drain_mu_);
+  Drain();
+}
+
+void AsyncWriter::Start(Config config) {
+  std::lock_guard<std::mutex> lock(global_mu);
+  if (global_.load(std::memory_order_relaxed) != nullptr) {
+    return;
+  }
+  global_.store(new AsyncWriter{config}, std::memory_order_release);
+}
+
+void AsyncWriter::Stop() {
+  std::lock_guard<std::mutex> lock(global_mu);
+  delete global_.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+AsyncWriter::Ring* AsyncWriter::LocalRing() {
+  if (local_ring_.writer_id == id_) {
+    return local_ring_.ring.get();
+  }
+
+  auto ring = std::make_shared<Ring>(config_.buffer_size);
+  {
+    std::lock_guard<std::mutex> lock(rings_mu_);
+    rings_.push_back(ring);
+  }
+  // Release the ring of the previous writer, if any.
+  local_ring_.Release();
+  local_ring_.writer_id = id_;
+  local_ring_.ring = std::move(ring);
+  return local_ring_.ring.get();
+}
+
+void AsyncWriter::Drain() {
+  std::vector<Ring*> rings;
+  {
+    std::lock_guard<std::mutex> lock(rings_mu_);
+    for (const auto& ring : rings_) {
+      rings.push_back(ring.get());
+    }
+  }
+
+  std::unordered_set<FILE*> files;
+  std::string scratch;
+  uint64_t dropped = 0;
+  std::vector<Ring*> released;
+  for (Ring* ring : rings) {
+    // Check before popping, so a released ring is known to be empty after.
+    if (ring->released()) {
+      released.push_back(ring);
+    }
+    WriteRecords(ring, &scratch, &files);
+    dropped += ring->TakeDropped();
+  }
+
+  // Free the rings of exited threads, so short lived threads don't grow the
+  // writer.
+  if (!released.empty()) {
+    std::lock_guard<std::mutex> lock(rings_mu_);
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                [&](const std::shared_ptr<Ring>& ring) {
+                                  return std::find(released.begin(),
+                                                   released.end(),
+                                                   ring.get()) !=
+                                         released.end();
+                                }),
+                 rings_.end());
+  }
+
+  if (dropped > 0) {
+    fmt::print(stderr, "log: dropped {} records as the log buffer is full\n",
+               dropped);
+  }
+  for (FILE* file : files) {
+    fflush(file);
+  }
+}
+
+void AsyncWriter::FlushLocal() {
+  if (local_ring_.writer_id != id_) {
+    // The thread hasn't buffered any records.
+    return;
+  }
+
+  std::unordered_set<FILE*> files;
+  std::string scratch;
+  {
+    std::lock_guard<std::mutex> lock(drain_mu_);
+    WriteRecords(local_ring_.ring.get(), &scratch, &files);
+  }
+  for (FILE* file : files) {
+    fflush(file);
+  }
+}
+
+void AsyncWriter::WriteRecords(Ring* ring, std::string* scratch,
+                               std::unordered_set<FILE*>* files) {
+  fmt::memory_buffer formatted;
+  ring->Pop(scratch, [&](const RecordHeader& header, const char* data) {
+    if (header.format) {
+      formatted.clear();
+      header.format(data, &formatted);
+      fwrite(formatted.data(), 1, formatted.size(), header.file);
+    } else {
+      fwrite(data, 1, header.size, header.file);
+    }
+    files->insert(header.file);
+  });
+}
+
+void AsyncWriter::Run() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (!stopped_) {
+    cv_.wait_for(lock, config_.flush_interval);
+    lock.unlock();
+    Flush();
+    lock.lock();
+  }
+}
+
+}  // namespace log
+}  // namespace puddle
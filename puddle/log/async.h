@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "fmt/format.h"
+
+namespace puddle {
+namespace log {
+
+// AsyncWriter writes log records to their files from a background thread.
+//
+// Each logging thread appends records to its own lock-free ring buffer, so
+// logging doesn't contend with other threads or block on a write syscall.
+// The background thread periodically drains all buffers and writes the
+// records in batches.
+//
+// Records may also be deferred, where the buffer contains the encoded log
+// rather than the formatted record, and the writer formats the record before
+// writing (see deferred.h).
+//
+// If a thread's buffer is full, records are dropped rather than blocking the
+// logging thread, and the number of dropped records is reported by the
+// writer.
+class AsyncWriter {
+ public:
+  // Formats an encoded deferred log into buf.
+  using FormatFn = void (*)(const char* data, fmt::memory_buffer* buf);
+
+  struct Config {
+    // Size of each threads ring buffer in bytes. Must be a power of 2.
+    size_t buffer_size;
+
+    // Interval to write buffered records.
+    std::chrono::milliseconds flush_interval;
+
+    static Config Default();
+  };
+
+  explicit AsyncWriter(Config config = Config::Default());
+
+  // Stops the background thread and writes any buffered records.
+  ~AsyncWriter();
+
+  AsyncWriter(const AsyncWriter& w) = delete;
+  AsyncWriter& operator=(const AsyncWriter& w) = delete;
+
+  AsyncWriter(AsyncWriter&& w) = delete;
+  AsyncWriter& operator=(AsyncWriter&& w) = delete;
+
+  // Appends the record to the calling threads buffer to be written to the
+  // given file.
+  void Write(FILE* file, std::string_view record);
+
+  // Appends the encoded log to the calling threads buffer, to be formatted
+  // with format and written to the given file.
+  void Write(FILE* file, FormatFn format, std::string_view data);
+
+  // Writes all buffered records from all threads, blocking until written.
+  void Flush();
+
+  // Writes the calling threads buffered records, blocking until written. This
+  // is cheaper than Flush for a thread that writes a record directly, and
+  // only needs its own records written first to keep them in order.
+  void FlushLocal();
+
+  // Starts the global writer used by all loggers. Has no effect if the global
+  // writer is already started.
+  static void Start(Config config = Config::Default());
+
+  // Stops the global writer, writing any buffered records. Must only be called
+  // when no other threads are logging.
+  static void Stop();
+
+  // Returns the global writer, or nullptr if logs are written synchronously.
+  static AsyncWriter* global() {
+    return global_.load(std::memory_order_acquire);
+  }
+
+ private:
+  // Single producer single consumer byte ring buffer.
+  class Ring;
+
+  // The calling threads ring buffer and the ID of the writer that owns it.
+  // Releases the ring when the thread exits, so the writer frees it once
+  // drained.
+  struct ThreadRing;
+
+  // Returns the calling threads ring buffer, creating it if needed.
+  Ring* LocalRing();
+
+  // Writes the records in all ring buffers. Must be called with drain_mu_
+  // held.
+  void Drain();
+
+  // Writes the records in the ring buffer, adding the written files to files.
+  // Must be called with drain_mu_ held.
+  static void WriteRecords(Ring* ring, std::string* scratch,
+                           std::unordered_set<FILE*>* files);
+
+  void Run();
+
+  Config config_;
+
+  // Identifies this writer in the threads cached ring buffer. As writers may
+  // be started and stopped, the writer address isn't unique.
+  uint64_t id_;
+
+  // Guards rings_.
+  std::mutex rings_mu_;
+
+  // Ring buffers are shared with the owning threads ThreadRing, so a ring
+  // outlives the writer if its thread is still running.
+  std::vector<std::shared_ptr<Ring>> rings_;
+
+  // Ensures there is only one consumer of the ring buffers at a time.
+  std::mutex drain_mu_;
+
+  // Guards stopped_ and wakes the background thread.
+  std::mutex mu_;
+
+  std::condition_variable cv_;
+
+  bool stopped_;
+
+  std::thread thread_;
+
+  static std::atomic<AsyncWriter*> global_;
+
+  static thread_local ThreadRing local_ring_;
+};
+
+}  // namespace log
+}  // namespace puddle
@@ -0,0 +1,181 @@
+#include "puddle/log/control.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include "puddle/log/registry.h"
+
+namespace puddle {
+namespace log {
+
+namespace {
+
+std::mutex global_mu;
+
+ControlServer* global_server = nullptr;
+
+// Maximum size of a command line, so a client that never sends a newline
+// can't grow the buffer without limit.
+constexpr size_t kMaxCommand = 8192;
+
+// Writes all size bytes, ignoring errors as the client may have closed the
+// connection.
+void WriteAll(int fd, const char* buf, size_t size) {
+  while (size > 0) {
+    ssize_t n = write(fd, buf, size);
+    if (n <= 0) {
+      return;
+    }
+    buf += n;
+    size -= n;
+  }
+}
+
+}  // namespace
+
+void ControlServer::Start(const std::string& path) {
+  std::lock_guard<std::mutex> lock(global_mu);
+  if (global_server != nullptr) {
+    return;
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("log control path too long: " + path);
+  }
+  memcpy(addr.sun_path, path.data(), path.size());
+  socklen_t len = offsetof(struct sockaddr_un, sun_path) + path.size() + 1;
+  if (!path.empty() && path[0] == '@') {
+    // Abstract namespace addresses start with a null byte and aren't null
+    // terminated.
+    addr.sun_path[0] = '\0';
+    len--;
+  } else {
+    // Remove the socket file left by a previous process.
+    unlink(path.c_str());
+  }
+
+  int s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (s == -1) {
+    throw std::system_error(errno, std::system_category(), "socket");
+  }
+  if (bind(s, reinterpret_cast<struct sockaddr*>(&addr), len) == -1) {
+    int err = errno;
+    close(s);
+    throw std::system_error(err, std::system_category(), "socket bind");
+  }
+  if (listen(s, 16) == -1) {
+    int err = errno;
+    close(s);
+    throw std::system_error(err, std::system_category(), "socket listen");
+  }
+
+  // The server runs for the lifetime of the process.
+  global_server = new ControlServer{s};
+}
+
+ControlServer::ControlServer(int socket)
+    : socket_{socket}, logger_{"log.control"} {
+  thread_ = std::thread{&ControlServer::Run, this};
+  thread_.detach();
+}
+
+void ControlServer::Run() {
+  while (true) {
+    int conn = accept4(socket_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (conn == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      logger_.Error("control server accept: {}", strerror(errno));
+      return;
+    }
+    Serve(conn);
+    close(conn);
+  }
+}
+
+void ControlServer::Serve(int conn) {
+  std::string buf;
+  char read_buf[512];
+  while (true) {
+    ssize_t n = read(conn, read_buf, sizeof(read_buf));
+    if (n <= 0) {
+      return;
+    }
+    buf.append(read_buf, n);
+
+    size_t pos;
+    while ((pos = buf.find('\n')) != std::string::npos) {
+      std::string response = Handle(buf.substr(0, pos));
+      buf.erase(0, pos + 1);
+      WriteAll(conn, response.data(), response.size());
+    }
+    if (buf.size() > kMaxCommand) {
+      std::string response = "error: command too long\n";
+      WriteAll(conn, response.data(), response.size());
+      return;
+    }
+  }
+}
+
+std::string ControlServer::Handle(const std::string& command) {
+  std::istringstream ss{command};
+  std::string op;
+  ss >> op;
+
+  if (op == "set") {
+    std::string name;
+    std::string level_str;
+    if (!(ss >> name >> level_str)) {
+      return "error: usage: set <logger> <LEVEL>\n";
+    }
+    Level level = LevelFromString(level_str);
+    if (level == static_cast<Level>(-1)) {
+      return "error: unknown level: " + level_str + "\n";
+    }
+    Registry::global()->SetLevel(name, level);
+    logger_.Info("set log level: {} {}", name, level_str);
+    return "ok\n";
+  }
+
+  if (op == "reset") {
+    std::string name;
+    if (!(ss >> name)) {
+      return "error: usage: reset <logger>\n";
+    }
+    Registry::global()->ResetLevel(name);
+    logger_.Info("reset log level: {}", name);
+    return "ok\n";
+  }
+
+  if (op == "list") {
+    // Sort by name for readability.
+    auto levels = Registry::global()->Levels();
+    std::map<std::string, Level> sorted{levels.begin(), levels.end()};
+    std::string response;
+    for (const auto& e : sorted) {
+      response += e.first;
+      response += " ";
+      response += LevelToString(e.second);
+      response += "\n";
+    }
+    return response;
+  }
+
+  return "error: unknown command: " + op + "\n";
+}
+
+}  // namespace log
+}  // namespace puddle
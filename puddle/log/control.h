@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <thread>
+
+#include "puddle/log/log.h"
+
+namespace puddle {
+namespace log {
+
+// ControlServer accepts commands to change log levels while running on a
+// Unix socket, so debug logs can be enabled for a subsystem without
+// restarting.
+//
+// Each connection sends newline separated commands:
+// * "set <logger> <LEVEL>": Sets the level of the named loggers, or the
+// default level if logger is "*"
+// * "reset <logger>": Removes the level override for the named loggers
+// * "list": Lists the level of each logger
+//
+// Commands longer than 8KB close the connection.
+//
+// Such as:
+//   echo "set reactor DEBUG" | nc -U /tmp/puddle-log.sock
+//
+// The server runs on its own thread using blocking syscalls, so it doesn't
+// depend on (or affect) the reactors.
+class ControlServer {
+ public:
+  ControlServer(const ControlServer& s) = delete;
+  ControlServer& operator=(const ControlServer& s) = delete;
+
+  ControlServer(ControlServer&& s) = delete;
+  ControlServer& operator=(ControlServer&& s) = delete;
+
+  // Starts the global control server listening on the given Unix socket path,
+  // where a leading '@' uses the abstract namespace. Has no effect if the
+  // server is already started.
+  static void Start(const std::string& path);
+
+ private:
+  explicit ControlServer(int socket);
+
+  void Run();
+
+  void Serve(int conn);
+
+  // Handles the command, returning the response.
+  std::string Handle(const std::string& command);
+
+  int socket_;
+
+  std::thread thread_;
+
+  Logger logger_;
+};
+
+}  // namespace log
+}  // namespace puddle
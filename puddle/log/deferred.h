@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "fmt/format.h"
+#include "puddle/log/level.h"
+
+namespace puddle {
+namespace log {
+
+// Deferred formatting.
+//
+// Rather than formatting a log on the logging thread, deferred logs encode
+// the log metadata, format string and raw argument bytes, and the
+// AsyncWriter thread formats the record. Encoding is a few copies, so
+// enabled debug logs become cheap enough to leave on in production.
+//
+// Only logs whose arguments are all arithmetic, enums or strings are
+// deferred. Other logs (such as with user defined formatters, which may
+// reference state that changes before the writer formats the log) are
+// formatted on the logging thread as usual. This is decided at compile time
+// from the fmt::format_string argument types.
+
+// Enables or disables deferred formatting. Logs are only deferred when the
+// global AsyncWriter is started.
+void UseDeferredFormat(bool enabled);
+
+// Formats the record prefix, containing the level, timestamp and logger name.
+void FormatPrefix(Level level, std::chrono::system_clock::time_point time,
+                  std::string_view name, fmt::memory_buffer* buf);
+
+namespace internal {
+
+extern std::atomic<bool> use_deferred_format;
+
+// Encodes and decodes a deferred argument of type T.
+template <typename T, typename Enable = void>
+struct DeferredArg {
+  static constexpr bool kSupported = false;
+};
+
+template <typename T>
+struct DeferredArg<
+    T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>> {
+  static constexpr bool kSupported = true;
+
+  using Decoded = T;
+
+  static void Encode(const T& v, fmt::memory_buffer* buf) {
+    const char* p = reinterpret_cast<const char*>(&v);
+    buf->append(p, p + sizeof(T));
+  }
+
+  static T Decode(const char** data) {
+    T v;
+    memcpy(&v, *data, sizeof(T));
+    *data += sizeof(T);
+    return v;
+  }
+};
+
+// Strings are copied, so the argument doesn't have to outlive the log call.
+template <typename T>
+struct DeferredArg<
+    T, std::enable_if_t<std::is_same_v<T, const char*> ||
+                        std::is_same_v<T, char*> ||
+                        std::is_same_v<T, std::string> ||
+                        std::is_same_v<T, std::string_view>>> {
+  static constexpr bool kSupported = true;
+
+  using Decoded = std::string_view;
+
+  static void Encode(std::string_view v, fmt::memory_buffer* buf) {
+    uint32_t size = v.size();
+    const char* p = reinterpret_cast<const char*>(&size);
+    buf->append(p, p + sizeof(size));
+    buf->append(v.data(), v.data() + v.size());
+  }
+
+  static std::string_view Decode(const char** data) {
+    uint32_t size;
+    memcpy(&size, *data, sizeof(size));
+    std::string_view v{*data + sizeof(size), size};
+    *data += sizeof(size) + size;
+    return v;
+  }
+};
+
+template <typename... T>
+inline constexpr bool kDeferrable =
+    (DeferredArg<std::decay_t<T>>::kSupported && ...);
+
+// Encodes the log into buf.
+template <typename... T>
+void EncodeDeferred(fmt::memory_buffer* buf, Level level,
+                    std::chrono::system_clock::time_point time,
+                    std::string_view name, std::string_view fmt,
+                    const T&... args) {
+  DeferredArg<Level>::Encode(level, buf);
+  DeferredArg<int64_t>::Encode(time.time_since_epoch().count(), buf);
+  DeferredArg<std::string_view>::Encode(name, buf);
+  DeferredArg<std::string_view>::Encode(fmt, buf);
+  (DeferredArg<std::decay_t<T>>::Encode(args, buf), ...);
+}
+
+// Decodes a log encoded by EncodeDeferred with argument types T, and formats
+// the record into buf.
+template <typename... T>
+void FormatDeferred(const char* data, fmt::memory_buffer* buf) {
+  Level level = DeferredArg<Level>::Decode(&data);
+  std::chrono::system_clock::time_point time{
+      std::chrono::system_clock::duration{
+          DeferredArg<int64_t>::Decode(&data)}};
+  std::string_view name = DeferredArg<std::string_view>::Decode(&data);
+  std::string_view fmt = DeferredArg<std::string_view>::Decode(&data);
+
+  // Braced initialization guarantees the arguments are decoded in order.
+  std::tuple<typename DeferredArg<std::decay_t<T>>::Decoded...> args{
+      DeferredArg<std::decay_t<T>>::Decode(&data)...};
+
+  FormatPrefix(level, time, name, buf);
+  std::apply(
+      [&](const auto&... args) {
+        fmt::vformat_to(std::back_inserter(*buf), fmt,
+                        fmt::make_format_args(args...));
+      },
+      args);
+  buf->push_back('\n');
+}
+
+}  // namespace internal
+
+}  // namespace log
+}  // namespace puddle
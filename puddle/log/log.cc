@@ -8,13 +8,78 @@ namespace log {
 Config Config::Default() {
   Config config;
   config.level = Level::kInfo;
+  config.cached_time = false;
+  config.async = false;
+  config.deferred = false;
   return config;
 }
 
-Logger::Logger(std::string name, FILE* file) : name_{name}, file_{file} {
+Logger::Logger(std::string name, FILE* file)
+    : name_{name}, file_{file}, level_{Level::kInfo} {
   // Register to set this loggers level based on the logger config.
   Registry::global()->Register(this);
 }
 
+Logger::~Logger() { Registry::global()->Unregister(this); }
+
+void Logger::FormatPrefix(Level level, fmt::memory_buffer* buf) {
+  log::FormatPrefix(level, Now(), name_, buf);
+}
+
+void Logger::WriteDeferred(AsyncWriter::FormatFn format,
+                           std::string_view data) {
+  AsyncWriter* writer = AsyncWriter::global();
+  if (writer) {
+    writer->Write(file_, format, data);
+    return;
+  }
+
+  // The writer was stopped since checking, so format synchronously.
+  fmt::memory_buffer buf;
+  format(data.data(), &buf);
+  fwrite(buf.data(), 1, buf.size(), file_);
+}
+
+namespace internal {
+
+std::atomic<bool> use_deferred_format{false};
+
+}  // namespace internal
+
+void UseDeferredFormat(bool enabled) {
+  internal::use_deferred_format.store(enabled, std::memory_order_relaxed);
+}
+
+void FormatPrefix(Level level, std::chrono::system_clock::time_point time,
+                  std::string_view name, fmt::memory_buffer* buf) {
+  thread_local TimestampCache timestamp_cache;
+
+  char timestamp[TimestampCache::kSize];
+  timestamp_cache.Format(time, timestamp);
+
+  std::string_view level_str = LevelToString(level);
+  buf->append(level_str.data(), level_str.data() + level_str.size());
+  buf->append(std::string_view{"  "});
+  buf->append(timestamp, timestamp + sizeof(timestamp));
+  buf->append(std::string_view{" ["});
+  buf->append(name.data(), name.data() + name.size());
+  buf->append(std::string_view{"] - "});
+}
+
+void Logger::Write(Level level, std::string_view record) {
+  AsyncWriter* writer = AsyncWriter::global();
+  if (writer && level > Level::kError) {
+    writer->Write(file_, record);
+    return;
+  }
+
+  if (writer) {
+    // Write the threads buffered records first so its records aren't
+    // reordered. Other threads records may be written after this record.
+    writer->FlushLocal();
+  }
+  fwrite(record.data(), 1, record.size(), file_);
+}
+
 }  // namespace log
 }  // namespace puddle
@@ -1,13 +1,20 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <cstdlib>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include "fmt/chrono.h"
 #include "fmt/core.h"
+#include "fmt/format.h"
+#include "puddle/log/async.h"
+#include "puddle/log/deferred.h"
 #include "puddle/log/level.h"
+#include "puddle/log/timestamp.h"
 
 namespace puddle {
 namespace log {
@@ -19,13 +26,33 @@ struct Config {
   // Overrides the level by logger name.
   std::unordered_map<std::string, Level> overrides;
 
+  // Whether to timestamp logs with the threads cached time (the reactor loop
+  // time) rather than reading the clock for each log. Logs in the same
+  // reactor loop iteration will have the same timestamp.
+  bool cached_time;
+
+  // Whether to write logs from a background thread using the global
+  // AsyncWriter. Fatal and error logs are always written synchronously.
+  bool async;
+
+  // Whether to defer formatting asynchronous logs to the AsyncWriter thread
+  // (see deferred.h). Only applies when async is enabled.
+  bool deferred;
+
+  // Path of a Unix socket to accept commands to change log levels while
+  // running (see ControlServer), or empty to disable.
+  std::string control_path;
+
   static Config Default();
 };
 
 // Logger writes logs to the provided file.
 //
+// By default logs are written synchronously. Starting the global AsyncWriter
+// (or setting Config::async) writes logs from a background thread instead.
+//
 // Each logger has a name and log level. The name can be used to add level
-// overrides to specific loggers.
+// overrides to specific loggers, including while running (see Registry).
 //
 // Each log record includes a level, timestamp, logger name and message.
 // Messages are formatted by fmtlib.
@@ -33,7 +60,16 @@ class Logger {
  public:
   Logger(std::string name, FILE* file = stderr);
 
-  std::string name() const { return name_; }
+  ~Logger();
+
+  // Loggers are registered by address so can't be copied or moved.
+  Logger(const Logger& l) = delete;
+  Logger& operator=(const Logger& l) = delete;
+
+  Logger(Logger&& l) = delete;
+  Logger& operator=(Logger&& l) = delete;
+
+  const std::string& name() const { return name_; }
 
   template <typename... T>
   void Fatal(fmt::format_string<T...> fmt, T&&... args) {
@@ -72,31 +108,59 @@ class Logger {
       return;
     }
 
-    // TODO(andydunstall): Rather than use FILE* buffering, buffer within the
-    // logger. Some levels shouldn't be buffered (fatal/error), but others can
-    // be then flushed periodically.
-
-    auto f = fmt::format(fmt, std::forward<T>(args)...);
-    // TODO(andydunstall): Formatting the timestamp for each log is expensive.
-    // Instead cache the formatted timestamp second, then only append the
-    // millisecond (see Seastar logger).
-    auto now = std::chrono::system_clock::now();
-    fmt::print(file_, "{}  {:%Y-%m-%d %T} [{}] - {}\n", LevelToString(level),
-               now, name_, f);
+    fmt::memory_buffer buf;
+    if constexpr (internal::kDeferrable<T...>) {
+      if (level > Level::kError &&
+          internal::use_deferred_format.load(std::memory_order_relaxed) &&
+          AsyncWriter::global() != nullptr) {
+        fmt::string_view fmt_str = fmt;
+        internal::EncodeDeferred(&buf, level, Now(), name_,
+                                 {fmt_str.data(), fmt_str.size()}, args...);
+        WriteDeferred(&internal::FormatDeferred<T...>,
+                      std::string_view{buf.data(), buf.size()});
+        return;
+      }
+    }
+
+    FormatPrefix(level, &buf);
+    fmt::format_to(std::back_inserter(buf), fmt, std::forward<T>(args)...);
+    buf.push_back('\n');
+    Write(level, std::string_view{buf.data(), buf.size()});
   }
 
+  // Returns whether logs at the given level are enabled. The level is read
+  // with a relaxed load, so is as cheap as a plain read, though may be
+  // changed concurrently by another thread.
   bool IsEnabled(Level level) const noexcept {
-    return __builtin_expect(level <= level_, false);
+    return __builtin_expect(level <= level_.load(std::memory_order_relaxed),
+                            false);
   }
 
-  void SetLevel(Level level) { level_ = level; }
+  Level level() const { return level_.load(std::memory_order_relaxed); }
+
+  void SetLevel(Level level) {
+    level_.store(level, std::memory_order_relaxed);
+  }
 
  private:
+  // Formats the record prefix, containing the level, timestamp and logger
+  // name.
+  void FormatPrefix(Level level, fmt::memory_buffer* buf);
+
+  // Writes the encoded deferred log to the AsyncWriter, to be formatted with
+  // format.
+  void WriteDeferred(AsyncWriter::FormatFn format, std::string_view data);
+
+  // Writes the formatted record to the file. If the global AsyncWriter is
+  // started, records are buffered and written in the background, except fatal
+  // and error records which are written synchronously.
+  void Write(Level level, std::string_view record);
+
   std::string name_;
 
   FILE* file_;
 
-  Level level_;
+  std::atomic<Level> level_;
 };
 
 }  // namespace log
@@ -1,6 +1,11 @@
 #include <benchmark/benchmark.h>
 
+#include <memory>
+
+#include "puddle/log/async.h"
 #include "puddle/log/log.h"
+#include "puddle/log/rate_limit.h"
+#include "puddle/log/timestamp.h"
 
 namespace {
 
@@ -18,17 +23,33 @@ FILE* OpenDevNull() {
 
 }  // namespace
 
-puddle::log::Logger logger{""};
+std::unique_ptr<puddle::log::Logger> logger;
 
 static void DoSetup(const benchmark::State& state) {
-  logger = puddle::log::Logger{"bench", OpenDevNull()};
+  logger = std::make_unique<puddle::log::Logger>("bench", OpenDevNull());
+  logger->SetLevel(puddle::log::Level::kInfo);
+}
+
+static void DoSetupAsync(const benchmark::State& state) {
+  DoSetup(state);
+  puddle::log::AsyncWriter::Start();
+}
+
+static void DoSetupDeferred(const benchmark::State& state) {
+  DoSetupAsync(state);
+  puddle::log::UseDeferredFormat(true);
+}
+
+static void DoTeardownAsync(const benchmark::State& state) {
+  puddle::log::UseDeferredFormat(false);
+  puddle::log::AsyncWriter::Stop();
 }
 
 template <typename... T>
 static void BM_Logger(benchmark::State& state, fmt::format_string<T...> fmt,
                       T&&... args) {
   for (auto _ : state) {
-    logger.Error(fmt, std::forward<T>(args)...);
+    logger->Error(fmt, std::forward<T>(args)...);
   }
 }
 
@@ -37,7 +58,7 @@ static void BM_LoggerDisabled(benchmark::State& state,
                               fmt::format_string<T...> fmt, T&&... args) {
   for (auto _ : state) {
     // Trace is disabled for the logger.
-    logger.Trace(fmt, std::forward<T>(args)...);
+    logger->Trace(fmt, std::forward<T>(args)...);
   }
 }
 
@@ -51,9 +72,97 @@ BENCHMARK_CAPTURE(BM_Logger, formatted_string, "my-log {} {} {} {} {}", "arg-1",
                   11111, "arg-2", 22222, "arg-3", 33333)
     ->Setup(DoSetup);
 
+// Compares synchronous and asynchronous logging with multiple threads
+// logging concurrently. Uses info logs as error logs are always written
+// synchronously.
+template <typename... T>
+static void BM_LoggerInfo(benchmark::State& state,
+                          fmt::format_string<T...> fmt, T&&... args) {
+  for (auto _ : state) {
+    logger->Info(fmt, std::forward<T>(args)...);
+  }
+}
+
+BENCHMARK_CAPTURE(BM_LoggerInfo, sync, "my-log {} {} {}", "arg-1", 11111,
+                  "arg-2")
+    ->Setup(DoSetup)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_LoggerInfo, async, "my-log {} {} {}", "arg-1", 11111,
+                  "arg-2")
+    ->Setup(DoSetupAsync)
+    ->Teardown(DoTeardownAsync)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+// Defers formatting to the writer thread.
+BENCHMARK_CAPTURE(BM_LoggerInfo, deferred, "my-log {} {} {}", "arg-1", 11111,
+                  "arg-2")
+    ->Setup(DoSetupDeferred)
+    ->Teardown(DoTeardownAsync)
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_LoggerInfo, deferred_formatted, "my-log {} {:.3f} {:>8}",
+                  11111, 3.14159, 22222)
+    ->Setup(DoSetupDeferred)
+    ->Teardown(DoTeardownAsync)
+    ->UseRealTime();
+
+// Isolates the cost of timestamping a log, comparing formatting the full
+// timestamp with fmt, the cached timestamp, and the cached timestamp using the
+// cached (reactor loop) time rather than reading the clock.
+static void BM_TimestampFmt(benchmark::State& state) {
+  fmt::memory_buffer buf;
+  for (auto _ : state) {
+    buf.clear();
+    fmt::format_to(std::back_inserter(buf), "{:%Y-%m-%d %T}",
+                   std::chrono::system_clock::now());
+    benchmark::DoNotOptimize(buf.data());
+  }
+}
+
+static void BM_TimestampCached(benchmark::State& state) {
+  puddle::log::TimestampCache cache;
+  char buf[puddle::log::TimestampCache::kSize];
+  for (auto _ : state) {
+    cache.Format(puddle::log::Now(), buf);
+    benchmark::DoNotOptimize(buf);
+  }
+}
+
+static void BM_TimestampCachedTime(benchmark::State& state) {
+  auto time = std::chrono::system_clock::now();
+  puddle::log::SetCachedTime(&time);
+  puddle::log::UseCachedTime(true);
+
+  puddle::log::TimestampCache cache;
+  char buf[puddle::log::TimestampCache::kSize];
+  for (auto _ : state) {
+    cache.Format(puddle::log::Now(), buf);
+    benchmark::DoNotOptimize(buf);
+  }
+
+  puddle::log::UseCachedTime(false);
+  puddle::log::SetCachedTime(nullptr);
+}
+
+BENCHMARK(BM_TimestampFmt);
+BENCHMARK(BM_TimestampCached);
+BENCHMARK(BM_TimestampCachedTime);
+
 // Logs to the disabled logger should have negligible overhead.
 BENCHMARK_CAPTURE(BM_LoggerDisabled, formatted_string, "my-log {} {} {} {} {}",
                   "arg-1", 11111, "arg-2", 22222, "arg-3", 33333)
     ->Setup(DoSetup);
 
+// Logs suppressed by the rate limiter should have negligible overhead, as
+// after the first burst nearly all logs are suppressed.
+static void BM_LoggerRateLimited(benchmark::State& state) {
+  for (auto _ : state) {
+    PUDDLE_LOG_RATE_LIMITED(*logger, puddle::log::Level::kInfo, 1, 1,
+                            "my-log {} {} {}", "arg-1", 11111, "arg-2");
+  }
+}
+
+BENCHMARK(BM_LoggerRateLimited)->Setup(DoSetup);
+
 BENCHMARK_MAIN();
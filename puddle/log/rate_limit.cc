@@ -0,0 +1,33 @@
+#include "puddle/log/rate_limit.h"
+
+#include <time.h>
+
+#include <algorithm>
+
+namespace puddle {
+namespace log {
+
+bool RateLimiter::Refill() {
+  // Logs are only rate limited to within a few milliseconds, so use the
+  // coarse clock which doesn't read the hardware clock.
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  uint64_t now_ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+  if (last_refill_ns_ == 0) {
+    last_refill_ns_ = now_ns;
+    return false;
+  }
+
+  uint64_t tokens = (now_ns - last_refill_ns_) / interval_ns_;
+  if (tokens == 0) {
+    return false;
+  }
+
+  tokens_ = std::min(burst_, tokens);
+  last_refill_ns_ += tokens * interval_ns_;
+  return true;
+}
+
+}  // namespace log
+}  // namespace puddle
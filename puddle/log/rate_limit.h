@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+
+#include "puddle/log/log.h"
+
+namespace puddle {
+namespace log {
+
+// RateLimiter is a token bucket limiting the rate of logs from a call site.
+//
+// The bucket holds up to burst tokens (at least one), and is refilled at
+// per_second tokens per second. Each allowed log takes a token. Logs are
+// suppressed when the bucket is empty, and the number of suppressed logs is
+// returned with the next allowed log.
+//
+// RateLimiter isn't thread safe. Call sites use a thread local limiter (see
+// PUDDLE_LOG_RATE_LIMITED), so the limit applies to each thread.
+class RateLimiter {
+ public:
+  constexpr RateLimiter(uint64_t per_second, uint64_t burst)
+      : interval_ns_{1000000000 / (per_second > 0 ? per_second : 1)},
+        burst_{burst > 0 ? burst : 1},
+        tokens_{burst > 0 ? burst : 1},
+        last_refill_ns_{0},
+        suppressed_{0} {}
+
+  // Returns whether to log. If allowed, sets suppressed to the number of logs
+  // suppressed since the last allowed log.
+  bool Allow(uint64_t* suppressed) {
+    if (__builtin_expect(tokens_ == 0, false) && !Refill()) {
+      suppressed_++;
+      return false;
+    }
+    tokens_--;
+    *suppressed = suppressed_;
+    suppressed_ = 0;
+    return true;
+  }
+
+ private:
+  // Adds tokens for the time since the last refill. Returns whether any
+  // tokens were added.
+  bool Refill();
+
+  // Interval to add a token.
+  uint64_t interval_ns_;
+
+  uint64_t burst_;
+
+  uint64_t tokens_;
+
+  uint64_t last_refill_ns_;
+
+  uint64_t suppressed_;
+};
+
+}  // namespace log
+}  // namespace puddle
+
+// Logs at the given level, rate limited by a per thread token bucket for the
+// call site, allowing bursts of up to burst logs then per_second logs per
+// second. The number of suppressed logs is logged after the next allowed log.
+//
+// Suppressed logs only cost a branch and a counter increment (plus reading
+// the coarse clock when the bucket is empty). Format arguments are not
+// evaluated when the log is suppressed.
+//
+// Example:
+//   PUDDLE_LOG_RATE_LIMITED(logger, puddle::log::Level::kError, 1, 10,
+//                           "connection failed: {}", e.what());
+#define PUDDLE_LOG_RATE_LIMITED(logger, level, per_second, burst, ...)        \
+  do {                                                                        \
+    static thread_local ::puddle::log::RateLimiter puddle_log_limiter{        \
+        per_second, burst};                                                   \
+    uint64_t puddle_log_suppressed;                                           \
+    if ((logger).IsEnabled(level) &&                                          \
+        puddle_log_limiter.Allow(&puddle_log_suppressed)) {                   \
+      (logger).Log(level, __VA_ARGS__);                                       \
+      if (puddle_log_suppressed > 0) {                                        \
+        (logger).Log(level, "suppressed {} messages", puddle_log_suppressed); \
+      }                                                                       \
+    }                                                                         \
+  } while (0)
+
+// Logs at the given level for every n-th call from this call site on each
+// thread, starting with the first. The n - 1 calls between logs are skipped
+// without noting them, as the number skipped is always the same.
+//
+// Example:
+//   PUDDLE_LOG_EVERY_N(logger, puddle::log::Level::kDebug, 1000,
+//                      "read {} bytes", n);
+#define PUDDLE_LOG_EVERY_N(logger, level, n, ...)                     \
+  do {                                                                \
+    static thread_local uint64_t puddle_log_count = 0;                \
+    if ((logger).IsEnabled(level) && puddle_log_count++ % (n) == 0) { \
+      (logger).Log(level, __VA_ARGS__);                               \
+    }                                                                 \
+  } while (0)
@@ -1,28 +1,83 @@
 #include "puddle/log/registry.h"
 
+#include <algorithm>
+
+#include "puddle/log/async.h"
+#include "puddle/log/control.h"
+#include "puddle/log/deferred.h"
+#include "puddle/log/timestamp.h"
+
 namespace puddle {
 namespace log {
 
+Registry::Registry() : config_{Config::Default()} {}
+
 void Registry::Register(Logger* logger) {
-  loggers_[logger->name()] = logger;
+  std::lock_guard<std::mutex> lock(mu_);
+  loggers_.push_back(logger);
 
   logger->SetLevel(LoggerLevel(logger->name()));
 }
 
+void Registry::Unregister(Logger* logger) {
+  std::lock_guard<std::mutex> lock(mu_);
+  loggers_.erase(std::remove(loggers_.begin(), loggers_.end(), logger),
+                 loggers_.end());
+}
+
 void Registry::SetConfig(Config config) {
-  config_ = config;
+  UseCachedTime(config.cached_time);
+  UseDeferredFormat(config.deferred);
+  if (config.async) {
+    AsyncWriter::Start();
+  }
+  if (!config.control_path.empty()) {
+    ControlServer::Start(config.control_path);
+  }
+
+  std::lock_guard<std::mutex> lock(mu_);
+  config_ = std::move(config);
+  ApplyConfig();
+}
 
-  for (const auto& e : loggers_) {
-    e.second->SetLevel(LoggerLevel(e.first));
+void Registry::SetLevel(const std::string& name, Level level) {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (name == "*") {
+    config_.level = level;
+  } else {
+    config_.overrides[name] = level;
   }
+  ApplyConfig();
 }
 
-Level Registry::LoggerLevel(std::string name) {
-  if (config_.overrides.find(name) != config_.overrides.end()) {
-    return config_.overrides[name];
+void Registry::ResetLevel(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mu_);
+  config_.overrides.erase(name);
+  ApplyConfig();
+}
+
+std::unordered_map<std::string, Level> Registry::Levels() {
+  std::lock_guard<std::mutex> lock(mu_);
+  std::unordered_map<std::string, Level> levels;
+  for (Logger* logger : loggers_) {
+    levels[logger->name()] = logger->level();
+  }
+  return levels;
+}
+
+Level Registry::LoggerLevel(const std::string& name) {
+  auto it = config_.overrides.find(name);
+  if (it != config_.overrides.end()) {
+    return it->second;
   }
   return config_.level;
 }
 
+void Registry::ApplyConfig() {
+  for (Logger* logger : loggers_) {
+    logger->SetLevel(LoggerLevel(logger->name()));
+  }
+}
+
 }  // namespace log
 }  // namespace puddle
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "puddle/log/log.h"
 
@@ -9,24 +11,53 @@ namespace puddle {
 namespace log {
 
 // Tracks and configures all loggers.
+//
+// The registry is thread safe, so loggers may be registered from any thread
+// and levels changed while running. Loggers read their level with a relaxed
+// atomic load, so changing levels adds no cost to logging.
 class Registry {
  public:
+  Registry();
+
   void Register(Logger* logger);
 
+  void Unregister(Logger* logger);
+
   void SetConfig(Config config);
 
+  // Sets the level of all loggers with the given name, or the default level
+  // if name is "*".
+  void SetLevel(const std::string& name, Level level);
+
+  // Removes the level override for loggers with the given name, so they use
+  // the default level.
+  void ResetLevel(const std::string& name);
+
+  // Returns the level of each registered logger name.
+  std::unordered_map<std::string, Level> Levels();
+
   // Returns the global registry, used to configure all loggers.
+  //
+  // The registry is never destroyed, so loggers with static storage duration
+  // can unregister at exit.
   static Registry* global() {
-    static Registry registry;
-    return &registry;
+    static Registry* registry = new Registry;
+    return registry;
   }
 
  private:
-  Level LoggerLevel(std::string name);
+  Level LoggerLevel(const std::string& name);
+
+  // Updates the level of all loggers from the config. Must be called with
+  // mu_ held.
+  void ApplyConfig();
+
+  std::mutex mu_;
 
   Config config_;
 
-  std::unordered_map<std::string, Logger*> loggers_;
+  // Multiple loggers may have the same name, such as a logger per reactor.
+  std::vector<Logger*> loggers_;
 };
 
 }  // namespace log
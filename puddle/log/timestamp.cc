@@ -0,0 +1,50 @@
+#include "puddle/log/timestamp.h"
+
+#include <cstring>
+#include <ctime>
+
+namespace puddle {
+namespace log {
+
+namespace internal {
+
+thread_local const std::chrono::system_clock::time_point* cached_time =
+    nullptr;
+
+std::atomic<bool> use_cached_time{false};
+
+}  // namespace internal
+
+void TimestampCache::Format(std::chrono::system_clock::time_point time,
+                            char* buf) {
+  int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   time.time_since_epoch())
+                   .count();
+  int64_t second = ms / 1000;
+  int millis = ms % 1000;
+
+  if (second != second_) {
+    time_t t = second;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(date_time_, sizeof(date_time_), "%Y-%m-%d %H:%M:%S", &tm);
+    second_ = second;
+  }
+
+  memcpy(buf, date_time_, sizeof(date_time_) - 1);
+  buf[19] = '.';
+  buf[20] = '0' + millis / 100;
+  buf[21] = '0' + millis / 10 % 10;
+  buf[22] = '0' + millis % 10;
+}
+
+void SetCachedTime(const std::chrono::system_clock::time_point* time) {
+  internal::cached_time = time;
+}
+
+void UseCachedTime(bool enabled) {
+  internal::use_cached_time.store(enabled, std::memory_order_relaxed);
+}
+
+}  // namespace log
+}  // namespace puddle
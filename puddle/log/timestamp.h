@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace puddle {
+namespace log {
+
+// TimestampCache formats log timestamps as "YYYY-MM-DD HH:MM:SS.mmm" (UTC).
+//
+// Formatting the date and time is expensive, so the formatted date and time
+// is cached and only reformatted when the second changes. Otherwise only the
+// milliseconds are formatted.
+class TimestampCache {
+ public:
+  // Size of a formatted timestamp in bytes.
+  static constexpr size_t kSize = 23;
+
+  // Formats the time into buf, which must have space for kSize bytes.
+  void Format(std::chrono::system_clock::time_point time, char* buf);
+
+ private:
+  // Second since the epoch of the cached date and time.
+  int64_t second_ = -1;
+
+  // Formatted "YYYY-MM-DD HH:MM:SS" for second_ (plus a null terminator).
+  char date_time_[20];
+};
+
+// Sets the calling threads cached time, which is used to timestamp logs
+// instead of reading the clock when cached time is enabled (see
+// Config::cached_time). time must remain valid until unset with nullptr.
+//
+// The reactor sets this to its loop time, which is updated once per event
+// loop iteration.
+void SetCachedTime(const std::chrono::system_clock::time_point* time);
+
+// Enables or disables using the threads cached time for log timestamps.
+void UseCachedTime(bool enabled);
+
+namespace internal {
+
+extern thread_local const std::chrono::system_clock::time_point* cached_time;
+
+extern std::atomic<bool> use_cached_time;
+
+}  // namespace internal
+
+// Returns the time to timestamp a log on the calling thread.
+inline std::chrono::system_clock::time_point Now() {
+  if (internal::use_cached_time.load(std::memory_order_relaxed) &&
+      internal::cached_time != nullptr) {
+    return *internal::cached_time;
+  }
+  return std::chrono::system_clock::now();
+}
+
+}  // namespace log
+}  // namespace puddle
@@ -0,0 +1,19 @@
+#include "puddle/net/addr.h"
+
+namespace puddle {
+namespace net {
+
+SocketAddr ParseAddr(const std::string& addr) {
+  return internal::ParseAddr(addr);
+}
+
+SocketAddr ParseUnixAddr(const std::string& path) {
+  return internal::ParseUnixAddr(path);
+}
+
+std::string FormatAddr(const SocketAddr& addr) {
+  return internal::FormatAddr(addr);
+}
+
+}  // namespace net
+}  // namespace puddle
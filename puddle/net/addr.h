@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "puddle/internal/addr.h"
+
+namespace puddle {
+namespace net {
+
+using SocketAddr = internal::SocketAddr;
+
+// Parses an address of the form ip:port, where IPv6 addresses are enclosed
+// in brackets (such as [::1]:4411). If the ip is empty, uses the IPv4
+// INADDR_ANY. Use [::]:port to bind to all IPv4 and IPv6 addresses
+// (dual-stack).
+SocketAddr ParseAddr(const std::string& addr);
+
+// Parses a Unix domain socket address, which is either a file system path, or
+// a name in the abstract namespace if prefixed with '@'.
+SocketAddr ParseUnixAddr(const std::string& path);
+
+// Formats the address as ip:port (with IPv6 addresses enclosed in brackets),
+// or the path for Unix domain sockets.
+std::string FormatAddr(const SocketAddr& addr);
+
+}  // namespace net
+}  // namespace puddle
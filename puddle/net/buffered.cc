@@ -0,0 +1,193 @@
+#include "puddle/net/buffered.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace puddle {
+namespace net {
+
+BufferedConn::Config BufferedConn::Config::Default() {
+  Config config;
+  config.read_buffer_size = 4096;
+  config.write_buffer_size = 4096;
+  return config;
+}
+
+BufferedConn::BufferedConn(TcpConn conn, Config config)
+    : conn_{std::move(conn)},
+      read_buf_(config.read_buffer_size),
+      read_pos_{0},
+      read_end_{0},
+      write_buf_(config.write_buffer_size),
+      write_len_{0},
+      flushed_{0},
+      flushing_{false},
+      flush_error_{0} {}
+
+BufferedConn::~BufferedConn() {
+  try {
+    Flush();
+  } catch (const std::exception& e) {
+    // Ignore errors as the connection is being discarded.
+  }
+}
+
+size_t BufferedConn::Read(uint8_t* buf, size_t size) {
+  if (read_pos_ == read_end_) {
+    // If the read is larger than the buffer, read directly into the callers
+    // buffer to avoid an extra copy.
+    if (size >= read_buf_.size()) {
+      return conn_.Read(buf, size);
+    }
+    if (Fill() == 0) {
+      return 0;
+    }
+  }
+
+  size_t n = std::min(size, read_end_ - read_pos_);
+  memcpy(buf, read_buf_.data() + read_pos_, n);
+  read_pos_ += n;
+  return n;
+}
+
+void BufferedConn::ReadFull(uint8_t* buf, size_t size) {
+  size_t n_read = 0;
+  while (n_read < size) {
+    size_t n = Read(buf + n_read, size - n_read);
+    if (n == 0) {
+      throw std::runtime_error{"connection closed"};
+    }
+    n_read += n;
+  }
+}
+
+bool BufferedConn::ReadLine(std::string* line, size_t max_size) {
+  line->clear();
+  while (true) {
+    if (read_pos_ == read_end_ && Fill() == 0) {
+      return false;
+    }
+
+    const uint8_t* begin = read_buf_.data() + read_pos_;
+    size_t available = read_end_ - read_pos_;
+    const uint8_t* delim =
+        static_cast<const uint8_t*>(memchr(begin, '\n', available));
+    size_t n = delim != nullptr ? delim - begin : available;
+    if (n > max_size - line->size()) {
+      throw std::length_error{"line exceeds maximum size"};
+    }
+    line->append(reinterpret_cast<const char*>(begin), n);
+    if (delim != nullptr) {
+      read_pos_ += n + 1;
+      return true;
+    }
+
+    // The line continues past the buffered bytes.
+    read_pos_ = read_end_;
+  }
+}
+
+void BufferedConn::Write(const uint8_t* buf, size_t size) {
+  WaitFlush();
+
+  if (write_len_ + size > write_buf_.size()) {
+    Flush();
+
+    // If the write is larger than the buffer, write directly from the callers
+    // buffer to avoid an extra copy.
+    if (size >= write_buf_.size()) {
+      size_t n_written = 0;
+      while (n_written < size) {
+        n_written += conn_.Write(buf + n_written, size - n_written);
+      }
+      return;
+    }
+  }
+
+  memcpy(write_buf_.data() + write_len_, buf, size);
+  write_len_ += size;
+
+  // Flush the buffered bytes when the task is next switched out.
+  internal::Reactor::local()->active()->AddSuspendHook(this);
+}
+
+void BufferedConn::Flush() {
+  WaitFlush();
+
+  // Unregister before writing, otherwise the hook would start an automatic
+  // flush when the write suspends the task.
+  Unregister();
+
+  size_t n_written = 0;
+  while (n_written < write_len_) {
+    size_t n =
+        conn_.Write(write_buf_.data() + n_written, write_len_ - n_written);
+    if (n == 0) {
+      // A write that makes no progress would retry forever.
+      write_len_ = 0;
+      throw std::system_error(EPIPE, std::system_category(), "socket write");
+    }
+    n_written += n;
+  }
+  write_len_ = 0;
+}
+
+size_t BufferedConn::Fill() {
+  read_pos_ = 0;
+  read_end_ = conn_.Read(read_buf_.data(), read_buf_.size());
+  return read_end_;
+}
+
+void BufferedConn::WaitFlush() {
+  while (flushing_) {
+    flush_queue_.SuspendAndWait(internal::Reactor::local()->active());
+  }
+  if (flush_error_ != 0) {
+    throw std::system_error(flush_error_, std::system_category(),
+                            "socket write");
+  }
+}
+
+void BufferedConn::SubmitFlush() {
+  conn_.socket_.WriteAsync(write_buf_.data() + flushed_, write_len_ - flushed_,
+                           this);
+}
+
+void BufferedConn::OnSuspend() {
+  if (flushing_ || write_len_ == 0 || flush_error_ != 0) {
+    return;
+  }
+
+  flushing_ = true;
+  flushed_ = 0;
+  SubmitFlush();
+}
+
+void BufferedConn::Complete(int result, uint32_t flags) {
+  if (result < 0) {
+    // Keep the error so it's returned by the next Write or Flush. The
+    // buffered bytes are discarded as the connection can't be written to.
+    flush_error_ = -result;
+  } else if (result == 0) {
+    // The write made no progress, so resubmitting would retry forever.
+    flush_error_ = EPIPE;
+  } else {
+    flushed_ += result;
+    if (flushed_ < write_len_) {
+      // Partial write so submit the remaining bytes.
+      SubmitFlush();
+      return;
+    }
+  }
+
+  write_len_ = 0;
+  flushed_ = 0;
+  flushing_ = false;
+  flush_queue_.NotifyAll();
+}
+
+}  // namespace net
+}  // namespace puddle
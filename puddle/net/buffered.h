@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "puddle/internal/context.h"
+#include "puddle/internal/reactor.h"
+#include "puddle/internal/sync.h"
+#include "puddle/net/tcp.h"
+
+namespace puddle {
+namespace net {
+
+// BufferedConn wraps a TcpConn with a read buffer and a write buffer.
+//
+// The read buffer means parsing small fields (such as lines or length
+// prefixes) doesn't require a syscall per field.
+//
+// The write buffer coalesces small writes into a single write. Buffered
+// writes are flushed when Flush is called, when the buffer is full, or
+// automatically before the writing task next yields or suspends (such as
+// when waiting for the next request). Automatic flushes are submitted without
+// blocking the task, so any error is returned by the next Write or Flush.
+//
+// A BufferedConn must only be used by one task at a time.
+class BufferedConn final : private internal::SuspendHook,
+                           private internal::Completion {
+ public:
+  struct Config {
+    // Size of the read buffer in bytes.
+    size_t read_buffer_size;
+
+    // Size of the write buffer in bytes.
+    size_t write_buffer_size;
+
+    static Config Default();
+  };
+
+  BufferedConn(TcpConn conn, Config config = Config::Default());
+
+  // Flushes any buffered writes. As errors can't be returned, callers that
+  // need to handle write errors should Flush before destructing.
+  ~BufferedConn();
+
+  BufferedConn(const BufferedConn& c) = delete;
+  BufferedConn& operator=(const BufferedConn& c) = delete;
+
+  BufferedConn(BufferedConn&& c) = delete;
+  BufferedConn& operator=(BufferedConn&& c) = delete;
+
+  // Reads up to size bytes, returning the number of bytes read or 0 if the
+  // connection is closed.
+  size_t Read(uint8_t* buf, size_t size);
+
+  // Reads exactly size bytes. Throws if the connection is closed first.
+  void ReadFull(uint8_t* buf, size_t size);
+
+  // Reads up to and including the next '\n', and sets line to the read bytes
+  // excluding the '\n'. Returns false if the connection is closed before a
+  // '\n' is read. Throws std::length_error if the line exceeds max_size
+  // bytes, so a peer can't make the line grow without bound.
+  bool ReadLine(std::string* line, size_t max_size = SIZE_MAX);
+
+  // Writes all size bytes to the write buffer, flushing if the buffer is full.
+  void Write(const uint8_t* buf, size_t size);
+
+  // Writes any buffered bytes to the connection.
+  void Flush();
+
+  // Returns the number of bytes in the write buffer that haven't been
+  // flushed.
+  size_t buffered() const { return write_len_; }
+
+ private:
+  // Fills the read buffer, returning the number of bytes read or 0 if the
+  // connection is closed.
+  size_t Fill();
+
+  // Waits for an in-progress automatic flush to complete, then throws if the
+  // flush failed.
+  void WaitFlush();
+
+  // Submits a write of the remaining buffered bytes.
+  void SubmitFlush();
+
+  // Starts an automatic flush of the buffered bytes when the writing task is
+  // switched out.
+  void OnSuspend() override;
+
+  // Handles the result of an automatic flush write.
+  void Complete(int result, uint32_t flags) override;
+
+  TcpConn conn_;
+
+  std::vector<uint8_t> read_buf_;
+
+  // Offset of the first unread byte in read_buf_.
+  size_t read_pos_;
+
+  // Offset after the last unread byte in read_buf_.
+  size_t read_end_;
+
+  std::vector<uint8_t> write_buf_;
+
+  // Number of buffered bytes in write_buf_.
+  size_t write_len_;
+
+  // Number of bytes in write_buf_ written by the in-progress automatic flush.
+  size_t flushed_;
+
+  // Whether an automatic flush is in progress.
+  bool flushing_;
+
+  // Error from a failed automatic flush (errno), or 0 if there is no error.
+  int flush_error_;
+
+  // Queue of contexts waiting for the in-progress flush to complete.
+  internal::WaitQueue flush_queue_;
+};
+
+}  // namespace net
+}  // namespace puddle
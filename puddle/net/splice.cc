@@ -0,0 +1,37 @@
+#include "puddle/net/splice.h"
+
+#include "puddle/internal/pipe.h"
+
+namespace puddle {
+namespace net {
+
+uint64_t Pipe(TcpConn& from, TcpConn& to) {
+  internal::SplicePipe pipe = internal::SplicePipe::Open();
+
+  uint64_t n_copied = 0;
+  while (true) {
+    size_t n = pipe.Splice(from.socket_.fd(), -1, to.socket_.fd(),
+                           pipe.capacity());
+    if (n == 0) {
+      return n_copied;
+    }
+    n_copied += n;
+  }
+}
+
+uint64_t SendFile(int fd, off_t offset, size_t size, TcpConn& to) {
+  internal::SplicePipe pipe = internal::SplicePipe::Open();
+
+  uint64_t n_sent = 0;
+  while (n_sent < size) {
+    size_t n = pipe.Splice(fd, offset + n_sent, to.socket_.fd(), size - n_sent);
+    if (n == 0) {
+      break;
+    }
+    n_sent += n;
+  }
+  return n_sent;
+}
+
+}  // namespace net
+}  // namespace puddle
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+
+#include "puddle/net/tcp.h"
+
+namespace puddle {
+namespace net {
+
+// Pipe copies bytes from one connection to another until the `from`
+// connection is closed, returning the number of bytes copied.
+//
+// Bytes are spliced via a kernel pipe so are never copied to user space,
+// which is cheaper than reading into a buffer then writing for bulk
+// transfers (such as proxying).
+uint64_t Pipe(TcpConn& from, TcpConn& to);
+
+// SendFile sends size bytes of the file fd, starting at offset, to the
+// connection. Returns the number of bytes sent, which is only less than size
+// if the end of the file is reached.
+//
+// Like Pipe, bytes are spliced via a kernel pipe so are never copied to
+// user space.
+uint64_t SendFile(int fd, off_t offset, size_t size, TcpConn& to);
+
+}  // namespace net
+}  // namespace puddle
@@ -1,5 +1,9 @@
 #include "puddle/net/tcp.h"
 
+#include <stdexcept>
+
+#include "puddle/internal/addr.h"
+
 namespace puddle {
 namespace net {
 
@@ -19,12 +23,13 @@ size_t TcpConn::Write(const uint8_t* buf, size_t size) {
 }
 
 TcpConn TcpConn::Connect(const std::string& addr) {
-  internal::TcpSocket socket = internal::TcpSocket::Open();
-  socket.Connect(addr);
+  internal::SocketAddr sock_addr = internal::ParseAddr(addr);
+  internal::Socket socket = internal::Socket::Open(sock_addr.family());
+  socket.Connect(sock_addr);
   return TcpConn{std::move(socket)};
 }
 
-TcpConn::TcpConn(internal::TcpSocket socket) : socket_{std::move(socket)} {}
+TcpConn::TcpConn(internal::Socket socket) : socket_{std::move(socket)} {}
 
 TcpListener::TcpListener(TcpListener&& l) { socket_ = std::move(l.socket_); }
 
@@ -34,18 +39,44 @@ TcpListener& TcpListener::operator=(TcpListener&& l) {
 }
 
 TcpConn TcpListener::Accept() {
-  internal::TcpSocket socket = socket_.Accept();
+  internal::Socket socket = socket_.Accept();
   return TcpConn{std::move(socket)};
 }
 
 TcpListener TcpListener::Bind(const std::string& addr, int backlog) {
-  internal::TcpSocket socket = internal::TcpSocket::Open();
-  socket.Bind(addr);
+  internal::SocketAddr sock_addr = internal::ParseAddr(addr);
+  internal::Socket socket = internal::Socket::Open(sock_addr.family());
+  socket.Bind(sock_addr);
   socket.Listen(backlog);
   return TcpListener{std::move(socket)};
 }
 
-TcpListener::TcpListener(internal::TcpSocket s) : socket_(std::move(s)) {}
+std::vector<TcpListener> TcpListener::BindSharded(const std::string& addr,
+                                                  int backlog, int shards) {
+  if (shards < 1) {
+    throw std::invalid_argument{"tcp listener: shards must be positive"};
+  }
+
+  internal::SocketAddr sock_addr = internal::ParseAddr(addr);
+
+  // The listeners must be bound in order, as the order determines their
+  // index in the SO_REUSEPORT group, which the steering program selects by.
+  std::vector<TcpListener> listeners;
+  for (int i = 0; i != shards; i++) {
+    internal::Socket socket = internal::Socket::Open(sock_addr.family());
+    socket.Bind(sock_addr, true);
+    socket.Listen(backlog);
+    listeners.push_back(TcpListener{std::move(socket)});
+  }
+
+  // The program applies to the whole group so only needs attaching to one
+  // listener.
+  listeners[0].socket_.AttachReusePortCpuSteering(shards);
+
+  return listeners;
+}
+
+TcpListener::TcpListener(internal::Socket s) : socket_(std::move(s)) {}
 
 }  // namespace net
 }  // namespace puddle
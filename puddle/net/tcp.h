@@ -1,14 +1,23 @@
 #pragma once
 
+#include <sys/types.h>
+
+#include <cstdint>
 #include <string>
+#include <vector>
 
-#include "puddle/internal/tcp.h"
+#include "puddle/internal/socket.h"
 
 namespace puddle {
 namespace net {
 
+class BufferedConn;
+class TcpConn;
 class TcpListener;
 
+uint64_t Pipe(TcpConn& from, TcpConn& to);
+uint64_t SendFile(int fd, off_t offset, size_t size, TcpConn& to);
+
 class TcpConn {
  public:
   TcpConn() = default;
@@ -26,11 +35,16 @@ class TcpConn {
   static TcpConn Connect(const std::string& addr);
 
  private:
+  friend BufferedConn;
   friend TcpListener;
 
-  TcpConn(internal::TcpSocket socket);
+  // Required for access to socket_.
+  friend uint64_t Pipe(TcpConn& from, TcpConn& to);
+  friend uint64_t SendFile(int fd, off_t offset, size_t size, TcpConn& to);
 
-  internal::TcpSocket socket_;
+  TcpConn(internal::Socket socket);
+
+  internal::Socket socket_;
 };
 
 class TcpListener {
@@ -45,12 +59,28 @@ class TcpListener {
 
   TcpConn Accept();
 
+  // Binds a listener to the address. Sets SO_REUSEADDR but not
+  // SO_REUSEPORT, so binding an address already in use fails (see
+  // BindSharded to share an address between listeners).
   static TcpListener Bind(const std::string& addr, int backlog);
 
+  // Binds the given number of listeners to the same address with
+  // SO_REUSEPORT, where the kernel steers each incoming connection to the
+  // listener whose index equals the CPU that processed the connection modulo
+  // the number of shards.
+  //
+  // This is used to run a listener per reactor thread, where thread i is
+  // pinned to CPU i (see Reactor::Config::cpu) and accepts from listener i,
+  // so connections are served by the same CPU that processes their packets.
+  //
+  // Throws std::invalid_argument if shards is less than 1.
+  static std::vector<TcpListener> BindSharded(const std::string& addr,
+                                              int backlog, int shards);
+
  private:
-  TcpListener(internal::TcpSocket s);
+  TcpListener(internal::Socket s);
 
-  internal::TcpSocket socket_;
+  internal::Socket socket_;
 };
 
 }  // namespace net
@@ -0,0 +1,73 @@
+#include "puddle/net/udp.h"
+
+namespace puddle {
+namespace net {
+
+UdpSocket::Config UdpSocket::Config::Default() {
+  Config config;
+  config.gro = false;
+  config.batch_buffer_size = 2048;
+  config.batch_buffers = 1024;
+  return config;
+}
+
+UdpSocket::UdpSocket(UdpSocket&& s) {
+  recv_ = std::move(s.recv_);
+  socket_ = std::move(s.socket_);
+  config_ = s.config_;
+}
+
+UdpSocket& UdpSocket::operator=(UdpSocket&& s) {
+  // Replace recv_ before socket_ so any existing multishot recvmsg is
+  // cancelled before its socket is closed.
+  recv_ = std::move(s.recv_);
+  socket_ = std::move(s.socket_);
+  config_ = s.config_;
+  return *this;
+}
+
+size_t UdpSocket::RecvFrom(uint8_t* buf, size_t size, SocketAddr* addr) {
+  return socket_.RecvFrom(buf, size, addr);
+}
+
+void UdpSocket::RecvBatch(std::vector<Datagram>* datagrams) {
+  if (!recv_) {
+    recv_ = std::make_unique<internal::MultishotRecv>(
+        socket_.fd(), config_.batch_buffer_size, config_.batch_buffers);
+  }
+  recv_->Recv(datagrams);
+}
+
+size_t UdpSocket::SendTo(const uint8_t* buf, size_t size,
+                         const SocketAddr& addr) {
+  return socket_.SendTo(buf, size, addr);
+}
+
+size_t UdpSocket::SendSegmented(const uint8_t* buf, size_t size,
+                                uint16_t segment_size, const SocketAddr& addr) {
+  return socket_.SendSegmented(buf, size, segment_size, addr);
+}
+
+UdpSocket UdpSocket::Bind(const std::string& addr, Config config) {
+  internal::SocketAddr sock_addr = internal::ParseAddr(addr);
+  internal::UdpSocket socket = internal::UdpSocket::Open(sock_addr.family());
+  socket.Bind(sock_addr);
+  if (config.gro) {
+    socket.EnableGro();
+  }
+  return UdpSocket{std::move(socket), config};
+}
+
+UdpSocket UdpSocket::Open(int family, Config config) {
+  internal::UdpSocket socket = internal::UdpSocket::Open(family);
+  if (config.gro) {
+    socket.EnableGro();
+  }
+  return UdpSocket{std::move(socket), config};
+}
+
+UdpSocket::UdpSocket(internal::UdpSocket socket, Config config)
+    : socket_{std::move(socket)}, config_{config} {}
+
+}  // namespace net
+}  // namespace puddle
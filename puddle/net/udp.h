@@ -0,0 +1,87 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "puddle/internal/udp.h"
+#include "puddle/net/addr.h"
+
+namespace puddle {
+namespace net {
+
+using Datagram = internal::Datagram;
+
+class UdpSocket {
+ public:
+  struct Config {
+    // Whether to enable generic receive offload, where the kernel coalesces
+    // datagrams from the same sender. Coalesced datagrams are split again by
+    // RecvBatch, though RecvFrom returns the coalesced datagrams.
+    bool gro;
+
+    // Size of each buffer used by RecvBatch. This must fit the largest
+    // expected datagram (or coalesced datagrams if gro is enabled), plus
+    // around 200 bytes for the datagrams address and metadata.
+    size_t batch_buffer_size;
+
+    // Number of buffers used by RecvBatch, which must be a power of 2.
+    unsigned batch_buffers;
+
+    static Config Default();
+  };
+
+  UdpSocket() = default;
+
+  UdpSocket(const UdpSocket& s) = delete;
+  UdpSocket& operator=(const UdpSocket& s) = delete;
+
+  UdpSocket(UdpSocket&& s);
+  UdpSocket& operator=(UdpSocket&& s);
+
+  // Receives a datagram into buf, returning the size of the datagram and
+  // setting addr to the senders address. If the datagram is larger than size
+  // it is truncated.
+  size_t RecvFrom(uint8_t* buf, size_t size, SocketAddr* addr);
+
+  // Receives a batch of datagrams, blocking until at least one datagram is
+  // received.
+  //
+  // Datagrams are received with a multishot recvmsg into a ring of provided
+  // buffers, so the kernel can receive many datagrams without the task
+  // submitting a request per datagram. The returned datagrams point to the
+  // provided buffers, so are only valid until the next call to RecvBatch.
+  void RecvBatch(std::vector<Datagram>* datagrams);
+
+  size_t SendTo(const uint8_t* buf, size_t size, const SocketAddr& addr);
+
+  // Sends the buffer as datagrams of segment_size bytes (where the last
+  // datagram may be smaller) with a single send, using generic segmentation
+  // offload.
+  size_t SendSegmented(const uint8_t* buf, size_t size, uint16_t segment_size,
+                       const SocketAddr& addr);
+
+  // Opens a UDP socket bound to the given address.
+  static UdpSocket Bind(const std::string& addr,
+                        Config config = Config::Default());
+
+  // Opens an unbound UDP socket with the given address family (AF_INET or
+  // AF_INET6), which is bound to an ephemeral port on the first send.
+  static UdpSocket Open(int family = AF_INET,
+                        Config config = Config::Default());
+
+ private:
+  UdpSocket(internal::UdpSocket socket, Config config);
+
+  internal::UdpSocket socket_;
+
+  Config config_{};
+
+  // Created on the first call to RecvBatch.
+  std::unique_ptr<internal::MultishotRecv> recv_;
+};
+
+}  // namespace net
+}  // namespace puddle
@@ -0,0 +1,76 @@
+#include "puddle/net/unix.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "puddle/internal/addr.h"
+
+namespace puddle {
+namespace net {
+
+UnixConn::UnixConn(UnixConn&& c) { socket_ = std::move(c.socket_); }
+
+UnixConn& UnixConn::operator=(UnixConn&& c) {
+  socket_ = std::move(c.socket_);
+  return *this;
+}
+
+size_t UnixConn::Read(uint8_t* buf, size_t size) {
+  return socket_.Read(buf, size);
+}
+
+size_t UnixConn::Write(const uint8_t* buf, size_t size) {
+  return socket_.Write(buf, size);
+}
+
+size_t UnixConn::ReadFds(uint8_t* buf, size_t size, std::vector<int>* fds) {
+  return socket_.ReadFds(buf, size, fds);
+}
+
+size_t UnixConn::WriteFds(const uint8_t* buf, size_t size,
+                          const std::vector<int>& fds) {
+  return socket_.WriteFds(buf, size, fds);
+}
+
+UnixConn UnixConn::Connect(const std::string& path) {
+  internal::Socket socket = internal::Socket::Open(AF_UNIX);
+  socket.Connect(internal::ParseUnixAddr(path));
+  return UnixConn{std::move(socket)};
+}
+
+UnixConn::UnixConn(internal::Socket socket) : socket_{std::move(socket)} {}
+
+UnixListener::~UnixListener() {
+  if (!path_.empty() && path_[0] != '@') {
+    unlink(path_.c_str());
+  }
+}
+
+UnixListener::UnixListener(UnixListener&& l) {
+  socket_ = std::move(l.socket_);
+  path_.swap(l.path_);
+}
+
+UnixListener& UnixListener::operator=(UnixListener&& l) {
+  socket_ = std::move(l.socket_);
+  path_.swap(l.path_);
+  return *this;
+}
+
+UnixConn UnixListener::Accept() {
+  internal::Socket socket = socket_.Accept();
+  return UnixConn{std::move(socket)};
+}
+
+UnixListener UnixListener::Bind(const std::string& path, int backlog) {
+  internal::Socket socket = internal::Socket::Open(AF_UNIX);
+  socket.Bind(internal::ParseUnixAddr(path));
+  socket.Listen(backlog);
+  return UnixListener{std::move(socket), path};
+}
+
+UnixListener::UnixListener(internal::Socket s, std::string path)
+    : socket_(std::move(s)), path_{std::move(path)} {}
+
+}  // namespace net
+}  // namespace puddle
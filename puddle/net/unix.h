@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "puddle/internal/socket.h"
+
+namespace puddle {
+namespace net {
+
+class UnixListener;
+
+// UnixConn is a Unix domain stream socket connection.
+//
+// Unix domain sockets skip the TCP/IP stack, so are cheaper than loopback TCP
+// for connections between processes on the same host.
+//
+// Addresses are file system paths, or names in the abstract namespace if
+// prefixed with '@' (which don't create a file and are removed when the
+// socket is closed).
+class UnixConn {
+ public:
+  UnixConn() = default;
+
+  UnixConn(const UnixConn& c) = delete;
+  UnixConn& operator=(const UnixConn& c) = delete;
+
+  UnixConn(UnixConn&& c);
+  UnixConn& operator=(UnixConn&& c);
+
+  size_t Read(uint8_t* buf, size_t size);
+
+  size_t Write(const uint8_t* buf, size_t size);
+
+  // Reads up to size bytes, and appends any file descriptors passed by the
+  // peer to fds. The caller owns the received file descriptors.
+  size_t ReadFds(uint8_t* buf, size_t size, std::vector<int>* fds);
+
+  // Writes up to size bytes (which must be at least 1) along with the given
+  // file descriptors, which are duplicated into the peer process. The caller
+  // still owns the given file descriptors.
+  size_t WriteFds(const uint8_t* buf, size_t size, const std::vector<int>& fds);
+
+  static UnixConn Connect(const std::string& path);
+
+ private:
+  friend UnixListener;
+
+  UnixConn(internal::Socket socket);
+
+  internal::Socket socket_;
+};
+
+class UnixListener {
+ public:
+  UnixListener() = default;
+
+  // Removes the socket file, unless the listener is in the abstract
+  // namespace.
+  ~UnixListener();
+
+  UnixListener(const UnixListener& l) = delete;
+  UnixListener& operator=(const UnixListener& l) = delete;
+
+  UnixListener(UnixListener&& l);
+  UnixListener& operator=(UnixListener&& l);
+
+  UnixConn Accept();
+
+  static UnixListener Bind(const std::string& path, int backlog);
+
+ private:
+  UnixListener(internal::Socket s, std::string path);
+
+  internal::Socket socket_;
+
+  std::string path_;
+};
+
+}  // namespace net
+}  // namespace puddle
@@ -17,4 +17,16 @@ void Start(Config config) {
   internal::Reactor::Start(config.reactor);
 }
 
+void Yield() { internal::Reactor::local()->Yield(); }
+
+void Suspend() { internal::Reactor::local()->Suspend(); }
+
+void SetTaskName(const char* name) {
+  internal::Reactor::local()->active()->set_name(name);
+}
+
+void SetTaskPriority(Priority priority) {
+  internal::Reactor::local()->active()->set_priority(priority);
+}
+
 }  // namespace puddle
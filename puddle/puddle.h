@@ -19,7 +19,13 @@ struct Config {
 // Start the puddle runtime.
 void Start(Config config = Config::Default());
 
-// Spawn a task (user-space thread).
+// Priority class of a task. Ready latency tasks always run before normal and
+// background tasks, and background tasks are limited to a share of the
+// reactor when normal tasks are also ready (see
+// internal::Scheduler::Config).
+using Priority = internal::Priority;
+
+// Spawn a task (user-space thread) with normal priority.
 template <typename Fn, typename... Arg>
 Task Spawn(Fn&& fn, Arg&&... arg) {
   auto context = internal::Reactor::local()->Spawn(std::forward<Fn>(fn),
@@ -27,6 +33,14 @@ Task Spawn(Fn&& fn, Arg&&... arg) {
   return Task{context};
 }
 
+// Spawn a task with the given priority.
+template <typename Fn, typename... Arg>
+Task SpawnWithPriority(Priority priority, Fn&& fn, Arg&&... arg) {
+  auto context = internal::Reactor::local()->SpawnWithPriority(
+      priority, std::forward<Fn>(fn), std::forward<Arg>(arg)...);
+  return Task{context};
+}
+
 // Yield the current task so the scheduler can switch to another task. The
 // current task will be added to the schedulers ready queue to be scheduled
 // again.
@@ -37,6 +51,15 @@ void Yield();
 // by another task to run again.
 void Suspend();
 
+// Sets the name of the current task, which identifies the task in traces
+// (see internal/trace.h). Tasks with the same name are traced together.
+// name must outlive the task, such as a string literal. Trace events copy at
+// most the first 31 bytes of the name.
+void SetTaskName(const char* name);
+
+// Sets the priority of the current task.
+void SetTaskPriority(Priority priority);
+
 template <typename Clock, typename Duration>
 void SleepUntil(const std::chrono::time_point<Clock, Duration>& time) {
   internal::Reactor::local()->SleepUntil(time);
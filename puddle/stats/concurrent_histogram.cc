@@ -0,0 +1,73 @@
+#include "puddle/stats/concurrent_histogram.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace puddle {
+namespace stats {
+
+namespace {
+
+std::atomic<int> next_thread_index{0};
+
+// Returns the index of the calling thread, assigned on first use.
+int ThreadIndex() {
+  thread_local int index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+// Returns shards if positive, so it is checked before allocating the shards.
+int CheckShards(int shards) {
+  if (shards <= 0) {
+    throw std::invalid_argument{"histogram: shards must be positive"};
+  }
+  return shards;
+}
+
+}  // namespace
+
+ConcurrentHistogram::ConcurrentHistogram(int shards)
+    : shards_{new Shard[CheckShards(shards)]}, n_shards_{shards} {}
+
+void ConcurrentHistogram::Add(uint64_t value, uint64_t count) {
+  Shard& shard = shards_[ThreadIndex() % n_shards_];
+
+  shard.buckets[Histogram::BucketIndex(value)].fetch_add(
+      count, std::memory_order_relaxed);
+  shard.num.fetch_add(count, std::memory_order_relaxed);
+  shard.sum.fetch_add(value * count, std::memory_order_relaxed);
+  shard.sum_squares.fetch_add(value * value * count,
+                              std::memory_order_relaxed);
+
+  // Only update the min and max when they change, which is rare once the
+  // histogram has a few samples.
+  uint64_t min = shard.min.load(std::memory_order_relaxed);
+  while (value < min && !shard.min.compare_exchange_weak(
+                            min, value, std::memory_order_relaxed)) {
+  }
+  uint64_t max = shard.max.load(std::memory_order_relaxed);
+  while (value > max && !shard.max.compare_exchange_weak(
+                            max, value, std::memory_order_relaxed)) {
+  }
+}
+
+Histogram ConcurrentHistogram::Snapshot() const {
+  Histogram h;
+  h.buckets_.resize(Histogram::kNumBuckets);
+  for (int i = 0; i != n_shards_; i++) {
+    const Shard& shard = shards_[i];
+    for (int b = 0; b != Histogram::kNumBuckets; b++) {
+      h.buckets_[b] += shard.buckets[b].load(std::memory_order_relaxed);
+    }
+    h.min_ = std::min(h.min_, shard.min.load(std::memory_order_relaxed));
+    h.max_ = std::max(h.max_, shard.max.load(std::memory_order_relaxed));
+    h.num_ += shard.num.load(std::memory_order_relaxed);
+    h.sum_ += shard.sum.load(std::memory_order_relaxed);
+    h.sum_squares_ += shard.sum_squares.load(std::memory_order_relaxed);
+  }
+  return h;
+}
+
+}  // namespace stats
+}  // namespace puddle
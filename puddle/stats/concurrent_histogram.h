@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "puddle/stats/histogram.h"
+
+namespace puddle {
+namespace stats {
+
+// ConcurrentHistogram is a histogram that can be recorded to from multiple
+// threads concurrently, such as a latency histogram shared by all reactors.
+//
+// Samples are recorded to a fixed number of shards, where each thread
+// records to the shard for its thread index. Shards are allocated up front
+// and updated with relaxed atomics, so Add never locks or allocates, and
+// threads only contend when they share a shard.
+//
+// Readers take a Snapshot, which merges the shards into a Histogram without
+// blocking writers. As buckets are read individually, a snapshot taken while
+// samples are being added may include only part of the concurrent samples.
+class ConcurrentHistogram {
+ public:
+  // Throws std::invalid_argument if shards isn't positive.
+  explicit ConcurrentHistogram(int shards = kDefaultShards);
+
+  ConcurrentHistogram(const ConcurrentHistogram& h) = delete;
+  ConcurrentHistogram& operator=(const ConcurrentHistogram& h) = delete;
+
+  ConcurrentHistogram(ConcurrentHistogram&& h) = default;
+  ConcurrentHistogram& operator=(ConcurrentHistogram&& h) = default;
+
+  void Add(uint64_t value) { Add(value, 1); }
+
+  void Add(uint64_t value, uint64_t count);
+
+  // Returns the merged samples from all shards.
+  Histogram Snapshot() const;
+
+  static constexpr int kDefaultShards = 16;
+
+ private:
+  // Padded to avoid false sharing between shards.
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> min{UINT64_MAX};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint64_t> num{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> sum_squares{0};
+    std::atomic<uint64_t> buckets[Histogram::kNumBuckets] = {};
+  };
+
+  std::unique_ptr<Shard[]> shards_;
+
+  int n_shards_;
+};
+
+}  // namespace stats
+}  // namespace puddle
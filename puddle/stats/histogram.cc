@@ -2,12 +2,41 @@
 
 #include <algorithm>
 #include <cmath>
+#include <stdexcept>
 
 #include "absl/numeric/bits.h"
 
 namespace puddle {
 namespace stats {
 
+namespace {
+
+// Version of the Serialize encoding.
+constexpr uint8_t kEncodingVersion = 1;
+
+void PutVarint(uint64_t v, std::string* s) {
+  while (v >= 0x80) {
+    s->push_back(static_cast<char>(v | 0x80));
+    v >>= 7;
+  }
+  s->push_back(static_cast<char>(v));
+}
+
+uint64_t GetVarint(std::string_view* s) {
+  uint64_t v = 0;
+  for (int shift = 0; shift < 64 && !s->empty(); shift += 7) {
+    uint8_t b = s->front();
+    s->remove_prefix(1);
+    v |= static_cast<uint64_t>(b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      return v;
+    }
+  }
+  throw std::runtime_error("invalid histogram encoding: bad varint");
+}
+
+}  // namespace
+
 const double Histogram::kBucketLimit[kNumBuckets] = {
     1,
     2,
@@ -189,9 +218,7 @@ double Histogram::StdDev() const {
 }
 
 void Histogram::Add(uint64_t value, uint64_t count) {
-  auto it =
-      std::upper_bound(kBucketLimit, kBucketLimit + kNumBuckets - 1, value);
-  size_t b = it - kBucketLimit;
+  size_t b = BucketIndex(value);
   if (buckets_.size() <= b) {
     buckets_.resize(absl::bit_ceil(b + 1));
   }
@@ -203,7 +230,7 @@ void Histogram::Add(uint64_t value, uint64_t count) {
   if (value > max_) {
     max_ = value;
   }
-  num_++;
+  num_ += count;
   sum_ += value * count;
   sum_squares_ += (value * value) * count;
 }
@@ -227,6 +254,72 @@ void Histogram::Merge(const Histogram& h) {
   sum_squares_ += h.sum_squares_;
 }
 
+std::string Histogram::Serialize() const {
+  std::string s;
+  s.push_back(kEncodingVersion);
+  PutVarint(min_, &s);
+  PutVarint(max_, &s);
+  PutVarint(num_, &s);
+  PutVarint(sum_, &s);
+  PutVarint(sum_squares_, &s);
+
+  uint64_t non_empty = 0;
+  for (uint64_t count : buckets_) {
+    non_empty += count != 0;
+  }
+  PutVarint(non_empty, &s);
+
+  // Encode the index as the delta from the previous non-empty bucket, so
+  // adjacent buckets take a single byte.
+  uint64_t prev = 0;
+  for (uint64_t b = 0; b < buckets_.size(); b++) {
+    if (buckets_[b] == 0) {
+      continue;
+    }
+    PutVarint(b - prev, &s);
+    PutVarint(buckets_[b], &s);
+    prev = b;
+  }
+  return s;
+}
+
+Histogram Histogram::Deserialize(std::string_view s) {
+  if (s.empty() || static_cast<uint8_t>(s.front()) != kEncodingVersion) {
+    throw std::runtime_error("invalid histogram encoding: bad version");
+  }
+  s.remove_prefix(1);
+
+  Histogram h;
+  h.min_ = GetVarint(&s);
+  h.max_ = GetVarint(&s);
+  h.num_ = GetVarint(&s);
+  h.sum_ = GetVarint(&s);
+  h.sum_squares_ = GetVarint(&s);
+
+  uint64_t non_empty = GetVarint(&s);
+  uint64_t b = 0;
+  for (uint64_t i = 0; i != non_empty; i++) {
+    b += GetVarint(&s);
+    if (b >= kNumBuckets) {
+      throw std::runtime_error("invalid histogram encoding: bad bucket");
+    }
+    if (h.buckets_.size() <= b) {
+      h.buckets_.resize(absl::bit_ceil(b + 1));
+    }
+    h.buckets_[b] = GetVarint(&s);
+  }
+  if (!s.empty()) {
+    throw std::runtime_error("invalid histogram encoding: trailing bytes");
+  }
+  return h;
+}
+
+size_t Histogram::BucketIndex(uint64_t value) {
+  auto it =
+      std::upper_bound(kBucketLimit, kBucketLimit + kNumBuckets - 1, value);
+  return it - kBucketLimit;
+}
+
 double Histogram::InterpolateVal(uint64_t bucket, uint64_t position) const {
   auto limits = BucketLimits(bucket);
 
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace puddle {
 namespace stats {
 
+class ConcurrentHistogram;
+class LocalHistogram;
+
 class Histogram {
  public:
   uint64_t Percentile(double p) const;
@@ -16,16 +21,36 @@ class Histogram {
 
   uint64_t max() const { return max_; }
 
+  uint64_t count() const { return num_; }
+
+  uint64_t sum() const { return sum_; }
+
   void Add(uint64_t value) { Add(value, 1); };
 
   void Add(uint64_t value, uint64_t count);
 
   void Merge(const Histogram& h);
 
+  // Encodes the histogram so it can be shipped to another process and
+  // merged. Only non-empty buckets are encoded, with varint bucket index
+  // deltas and counts, so a typical latency histogram encodes to tens of
+  // bytes.
+  std::string Serialize() const;
+
+  // Decodes a histogram encoded by Serialize. Throws std::runtime_error if
+  // the encoding is invalid.
+  static Histogram Deserialize(std::string_view s);
+
  private:
+  friend class ConcurrentHistogram;
+  friend class LocalHistogram;
+
   static constexpr int kNumBuckets = 154;
   static const double kBucketLimit[kNumBuckets];
 
+  // Returns the index of the bucket containing value.
+  static size_t BucketIndex(uint64_t value);
+
   double InterpolateVal(uint64_t bucket, uint64_t position) const;
 
   std::pair<double, double> BucketLimits(uint64_t b) const;
@@ -0,0 +1,120 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "puddle/stats/concurrent_histogram.h"
+#include "puddle/stats/histogram.h"
+#include "puddle/stats/local_histogram.h"
+#include "puddle/stats/log_linear_histogram.h"
+
+namespace {
+
+// Returns latency like samples (in microseconds) from a log-normal
+// distribution, with a median around 150us and a long tail.
+const std::vector<uint64_t>& Samples() {
+  static std::vector<uint64_t> samples = [] {
+    std::mt19937_64 rng{42};
+    std::lognormal_distribution<double> dist{5.0, 1.0};
+    std::vector<uint64_t> samples(1 << 16);
+    for (uint64_t& s : samples) {
+      s = static_cast<uint64_t>(dist(rng));
+    }
+    return samples;
+  }();
+  return samples;
+}
+
+// Returns the exact percentile of the samples.
+uint64_t ExactPercentile(std::vector<uint64_t> samples, double p) {
+  std::sort(samples.begin(), samples.end());
+  size_t i = std::min<size_t>(samples.size() * (p / 100.0), samples.size() - 1);
+  return samples[i];
+}
+
+// Sets counters with the relative error (%) of the histogram percentiles
+// compared to the exact percentiles.
+template <typename H>
+void SetErrorCounters(benchmark::State& state, const H& h) {
+  for (double p : {50.0, 99.0, 99.9}) {
+    double exact = ExactPercentile(Samples(), p);
+    double err = std::abs(h.Percentile(p) - exact) / exact * 100;
+    state.counters["p" + std::to_string(p).substr(0, 4) + "_err%"] = err;
+  }
+}
+
+}  // namespace
+
+static void BM_HistogramAdd(benchmark::State& state) {
+  const std::vector<uint64_t>& samples = Samples();
+  puddle::stats::Histogram h;
+  size_t i = 0;
+  for (auto _ : state) {
+    h.Add(samples[i++ & (samples.size() - 1)]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_LocalHistogramAdd(benchmark::State& state) {
+  const std::vector<uint64_t>& samples = Samples();
+  puddle::stats::LocalHistogram h;
+  size_t i = 0;
+  for (auto _ : state) {
+    h.Add(samples[i++ & (samples.size() - 1)]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ConcurrentHistogramAdd(benchmark::State& state) {
+  const std::vector<uint64_t>& samples = Samples();
+  puddle::stats::ConcurrentHistogram h{1};
+  size_t i = 0;
+  for (auto _ : state) {
+    h.Add(samples[i++ & (samples.size() - 1)]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_LogLinearHistogramAdd(benchmark::State& state) {
+  const std::vector<uint64_t>& samples = Samples();
+  puddle::stats::LogLinearHistogram h{static_cast<int>(state.range(0))};
+  size_t i = 0;
+  for (auto _ : state) {
+    h.Add(samples[i++ & (samples.size() - 1)]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Compares percentile accuracy, reported as counters.
+static void BM_HistogramPercentile(benchmark::State& state) {
+  puddle::stats::Histogram h;
+  for (uint64_t s : Samples()) {
+    h.Add(s);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(h.Percentile(99.0));
+  }
+  SetErrorCounters(state, h);
+}
+
+static void BM_LogLinearHistogramPercentile(benchmark::State& state) {
+  puddle::stats::LogLinearHistogram h{static_cast<int>(state.range(0))};
+  for (uint64_t s : Samples()) {
+    h.Add(s);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(h.Percentile(99.0));
+  }
+  SetErrorCounters(state, h);
+}
+
+BENCHMARK(BM_HistogramAdd);
+BENCHMARK(BM_LocalHistogramAdd);
+BENCHMARK(BM_ConcurrentHistogramAdd);
+BENCHMARK(BM_LogLinearHistogramAdd)->Arg(4)->Arg(7)->Arg(10);
+BENCHMARK(BM_HistogramPercentile);
+BENCHMARK(BM_LogLinearHistogramPercentile)->Arg(4)->Arg(7)->Arg(10);
+
+BENCHMARK_MAIN();
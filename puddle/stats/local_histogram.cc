@@ -0,0 +1,35 @@
+#include "puddle/stats/local_histogram.h"
+
+namespace puddle {
+namespace stats {
+
+void LocalHistogram::Add(uint64_t value, uint64_t count) {
+  Inc(&buckets_[Histogram::BucketIndex(value)], count);
+  Inc(&num_, count);
+  Inc(&sum_, value * count);
+  Inc(&sum_squares_, value * value * count);
+
+  if (value < min_.load(std::memory_order_relaxed)) {
+    min_.store(value, std::memory_order_relaxed);
+  }
+  if (value > max_.load(std::memory_order_relaxed)) {
+    max_.store(value, std::memory_order_relaxed);
+  }
+}
+
+Histogram LocalHistogram::Snapshot() const {
+  Histogram h;
+  h.buckets_.resize(Histogram::kNumBuckets);
+  for (int b = 0; b != Histogram::kNumBuckets; b++) {
+    h.buckets_[b] = buckets_[b].load(std::memory_order_relaxed);
+  }
+  h.min_ = min_.load(std::memory_order_relaxed);
+  h.max_ = max_.load(std::memory_order_relaxed);
+  h.num_ = num_.load(std::memory_order_relaxed);
+  h.sum_ = sum_.load(std::memory_order_relaxed);
+  h.sum_squares_ = sum_squares_.load(std::memory_order_relaxed);
+  return h;
+}
+
+}  // namespace stats
+}  // namespace puddle
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "puddle/stats/histogram.h"
+
+namespace puddle {
+namespace stats {
+
+// LocalHistogram is a histogram updated by one thread and read by any
+// thread, such as a histogram per reactor.
+//
+// Like Counter, Add is a relaxed load and store of each field rather than an
+// atomic read-modify-write, so is as cheap as adding to a Histogram. Use
+// ConcurrentHistogram to record from multiple threads.
+//
+// Readers take a Snapshot. As fields are read individually, a snapshot taken
+// while a sample is being added may include only part of the sample.
+class LocalHistogram {
+ public:
+  LocalHistogram() = default;
+
+  LocalHistogram(const LocalHistogram& h) = delete;
+  LocalHistogram& operator=(const LocalHistogram& h) = delete;
+
+  LocalHistogram(LocalHistogram&& h) = delete;
+  LocalHistogram& operator=(LocalHistogram&& h) = delete;
+
+  void Add(uint64_t value) { Add(value, 1); }
+
+  void Add(uint64_t value, uint64_t count);
+
+  Histogram Snapshot() const;
+
+ private:
+  static void Inc(std::atomic<uint64_t>* v, uint64_t n) {
+    v->store(v->load(std::memory_order_relaxed) + n,
+             std::memory_order_relaxed);
+  }
+
+  std::atomic<uint64_t> min_{UINT64_MAX};
+  std::atomic<uint64_t> max_{0};
+  std::atomic<uint64_t> num_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> sum_squares_{0};
+  std::atomic<uint64_t> buckets_[Histogram::kNumBuckets] = {};
+};
+
+}  // namespace stats
+}  // namespace puddle
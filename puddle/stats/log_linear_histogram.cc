@@ -0,0 +1,81 @@
+#include "puddle/stats/log_linear_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace puddle {
+namespace stats {
+
+LogLinearHistogram::LogLinearHistogram(int precision)
+    : precision_{precision} {
+  if (precision < 1 || precision > 16) {
+    throw std::invalid_argument("histogram precision must be between 1 and 16");
+  }
+  buckets_.resize(static_cast<size_t>(65 - precision) << precision);
+}
+
+uint64_t LogLinearHistogram::Percentile(double p) const {
+  uint64_t threshold = num_ * (p / 100.0);
+  uint64_t sum = 0;
+  for (size_t b = 0; b < buckets_.size(); b++) {
+    if (buckets_[b] == 0) {
+      continue;
+    }
+    sum += buckets_[b];
+    if (sum >= threshold) {
+      // Scale linearly within the bucket, as Histogram does.
+      uint64_t position = threshold - (sum - buckets_[b]);
+      double pos = double(position) / double(buckets_[b] + 1);
+      double r = BucketLow(b) + BucketWidth(b) * pos;
+      return std::clamp<double>(r, min_, max_);
+    }
+  }
+  return max_;
+}
+
+double LogLinearHistogram::Mean() const {
+  if (num_ == 0) {
+    return 0;
+  }
+  return static_cast<double>(sum_) / num_;
+}
+
+double LogLinearHistogram::StdDev() const {
+  if (num_ == 0) {
+    return 0;
+  }
+  double mean = Mean();
+  double variance = sum_squares_ / num_ - mean * mean;
+  return std::sqrt(std::max(variance, 0.0));
+}
+
+void LogLinearHistogram::Merge(const LogLinearHistogram& h) {
+  if (h.precision_ != precision_) {
+    throw std::invalid_argument("merge histograms with different precision");
+  }
+  for (size_t b = 0; b < buckets_.size(); b++) {
+    buckets_[b] += h.buckets_[b];
+  }
+
+  min_ = std::min(min_, h.min_);
+  max_ = std::max(max_, h.max_);
+  num_ += h.num_;
+  sum_ += h.sum_;
+  sum_squares_ += h.sum_squares_;
+}
+
+uint64_t LogLinearHistogram::BucketLow(size_t b) const {
+  // Buckets below 2^(precision + 1) have width 1, so the shift is 0.
+  int shift = std::max<int>(static_cast<int>(b >> precision_) - 1, 0);
+  uint64_t mantissa = b - (static_cast<uint64_t>(shift) << precision_);
+  return mantissa << shift;
+}
+
+uint64_t LogLinearHistogram::BucketWidth(size_t b) const {
+  int shift = std::max<int>(static_cast<int>(b >> precision_) - 1, 0);
+  return uint64_t{1} << shift;
+}
+
+}  // namespace stats
+}  // namespace puddle
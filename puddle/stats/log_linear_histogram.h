@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace puddle {
+namespace stats {
+
+// LogLinearHistogram is a histogram with log-linear buckets, like
+// HdrHistogram.
+//
+// Values are grouped by their most significant bit, then each group is
+// split into 2^precision linear buckets. So the bucket for a value is found
+// from the leading zero count and the next precision bits of the value,
+// making Add constant time with no branches on the bucket layout. Each
+// bucket covers at most 1/2^precision of its values, so percentiles have a
+// relative error of at most 2^-precision.
+//
+// Buckets cover the full uint64_t range and are allocated on construction,
+// so Add never allocates.
+class LogLinearHistogram {
+ public:
+  // Creates a histogram with 2^precision buckets per power of two. Precision
+  // must be between 1 and 16. Storage is (65 - precision) * 2^precision
+  // buckets, such as 58KB for the default precision of 7 (under 1% error).
+  explicit LogLinearHistogram(int precision = kDefaultPrecision);
+
+  uint64_t Percentile(double p) const;
+
+  double Mean() const;
+
+  double StdDev() const;
+
+  uint64_t min() const { return min_; }
+
+  uint64_t max() const { return max_; }
+
+  uint64_t count() const { return num_; }
+
+  int precision() const { return precision_; }
+
+  void Add(uint64_t value) { Add(value, 1); }
+
+  void Add(uint64_t value, uint64_t count) {
+    buckets_[BucketIndex(value)] += count;
+
+    if (value < min_) {
+      min_ = value;
+    }
+    if (value > max_) {
+      max_ = value;
+    }
+    num_ += count;
+    sum_ += value * count;
+    sum_squares_ += static_cast<double>(value) * value * count;
+  }
+
+  // Merges the samples from h, which must have the same precision.
+  void Merge(const LogLinearHistogram& h);
+
+  static constexpr int kDefaultPrecision = 7;
+
+ private:
+  size_t BucketIndex(uint64_t value) const {
+    // Values below 2^precision have a bucket each. Setting the precision bit
+    // means these values use the first group, where the shift is 0.
+    uint64_t v = value | (uint64_t{1} << precision_);
+    int shift = 63 - __builtin_clzll(v) - precision_;
+    return (static_cast<size_t>(shift) << precision_) + (value >> shift);
+  }
+
+  // Returns the lowest value in the bucket.
+  uint64_t BucketLow(size_t b) const;
+
+  // Returns the number of values in the bucket.
+  uint64_t BucketWidth(size_t b) const;
+
+  int precision_;
+
+  uint64_t min_ = UINT64_MAX;
+
+  uint64_t max_ = 0;
+
+  uint64_t num_ = 0;
+
+  uint64_t sum_ = 0;
+
+  double sum_squares_ = 0;
+
+  std::vector<uint64_t> buckets_;
+};
+
+}  // namespace stats
+}  // namespace puddle
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace puddle {
+namespace stats {
+
+// Counter is a monotonically increasing metric.
+//
+// A counter must only be updated by one thread, such as a counter per
+// reactor, though may be read by any thread. This means Inc is a relaxed load
+// and store rather than an atomic read-modify-write, so is as cheap as
+// incrementing a plain integer. Use a counter per thread and sum them when
+// reading to count from multiple threads.
+class Counter {
+ public:
+  void Inc(uint64_t n = 1) {
+    value_.store(value_.load(std::memory_order_relaxed) + n,
+                 std::memory_order_relaxed);
+  }
+
+  uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+// Gauge is a metric that can go up and down.
+//
+// Like Counter, a gauge must only be updated by one thread, though may be
+// read by any thread.
+class Gauge {
+ public:
+  void Set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+
+  void Add(int64_t n) {
+    value_.store(value_.load(std::memory_order_relaxed) + n,
+                 std::memory_order_relaxed);
+  }
+
+  int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+}  // namespace stats
+}  // namespace puddle
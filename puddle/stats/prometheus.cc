@@ -0,0 +1,128 @@
+#include "puddle/stats/prometheus.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace puddle {
+namespace stats {
+
+namespace {
+
+struct Family {
+  std::string name;
+  std::string help;
+  std::string type;
+
+  // Formatted samples.
+  std::string samples;
+};
+
+// Escapes a label value, where backslash, double quote and newline must be
+// escaped.
+std::string EscapeLabel(const std::string& s) {
+  std::string escaped;
+  for (char c : s) {
+    if (c == '\\') {
+      escaped += "\\\\";
+    } else if (c == '"') {
+      escaped += "\\\"";
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// Formats the labels, including the optional extra label (such as the
+// summary quantile), as "{name="value",...}".
+std::string FormatLabels(const Labels& labels, const std::string& extra = "") {
+  if (labels.empty() && extra.empty()) {
+    return "";
+  }
+
+  std::string s = "{";
+  for (const auto& label : labels) {
+    if (s.size() > 1) {
+      s += ",";
+    }
+    s += label.first + "=\"" + EscapeLabel(label.second) + "\"";
+  }
+  if (!extra.empty()) {
+    if (s.size() > 1) {
+      s += ",";
+    }
+    s += extra;
+  }
+  s += "}";
+  return s;
+}
+
+void AddSample(Family* family, const std::string& name,
+               const std::string& labels, const std::string& value) {
+  family->samples += name + labels + " " + value + "\n";
+}
+
+void AddSummary(Family* family, const MetricInfo& info, const Histogram& h) {
+  const std::pair<const char*, double> quantiles[] = {
+      {"0.5", 50.0}, {"0.9", 90.0}, {"0.99", 99.0}, {"0.999", 99.9}};
+  for (const auto& q : quantiles) {
+    AddSample(family, info.name,
+              FormatLabels(info.labels, std::string{"quantile=\""} + q.first +
+                                            "\""),
+              std::to_string(h.count() > 0 ? h.Percentile(q.second) : 0));
+  }
+  AddSample(family, info.name + "_sum", FormatLabels(info.labels),
+            std::to_string(h.sum()));
+  AddSample(family, info.name + "_count", FormatLabels(info.labels),
+            std::to_string(h.count()));
+}
+
+}  // namespace
+
+std::string FormatPrometheus(Registry* registry) {
+  // Families in the order they were first registered.
+  std::vector<Family> families;
+  std::unordered_map<std::string, size_t> family_index;
+
+  registry->ForEach([&](const MetricInfo& info) {
+    auto it = family_index.find(info.name);
+    if (it == family_index.end()) {
+      it = family_index.emplace(info.name, families.size()).first;
+      families.push_back(Family{info.name, info.help, "", ""});
+    }
+    Family* family = &families[it->second];
+
+    if (auto counter = std::get_if<const Counter*>(&info.metric)) {
+      family->type = "counter";
+      AddSample(family, info.name, FormatLabels(info.labels),
+                std::to_string((*counter)->value()));
+    } else if (auto gauge = std::get_if<const Gauge*>(&info.metric)) {
+      family->type = "gauge";
+      AddSample(family, info.name, FormatLabels(info.labels),
+                std::to_string((*gauge)->value()));
+    } else if (auto h = std::get_if<const ConcurrentHistogram*>(
+                   &info.metric)) {
+      family->type = "summary";
+      AddSummary(family, info, (*h)->Snapshot());
+    } else if (auto h = std::get_if<const LocalHistogram*>(&info.metric)) {
+      family->type = "summary";
+      AddSummary(family, info, (*h)->Snapshot());
+    } else if (auto h = std::get_if<const Histogram*>(&info.metric)) {
+      family->type = "summary";
+      AddSummary(family, info, **h);
+    }
+  });
+
+  std::string s;
+  for (const Family& family : families) {
+    s += "# HELP " + family.name + " " + family.help + "\n";
+    s += "# TYPE " + family.name + " " + family.type + "\n";
+    s += family.samples;
+  }
+  return s;
+}
+
+}  // namespace stats
+}  // namespace puddle
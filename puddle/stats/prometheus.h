@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+#include "puddle/stats/registry.h"
+
+namespace puddle {
+namespace stats {
+
+// Formats the metrics in the registry in the Prometheus text exposition
+// format.
+//
+// Counters and gauges are exported as is. Histograms are exported as
+// summaries with the 0.5, 0.9, 0.99 and 0.999 quantiles, plus the sample
+// count and sum. Metrics with the same name (such as a metric per reactor)
+// are grouped into one family, distinguished by their labels.
+std::string FormatPrometheus(Registry* registry = Registry::global());
+
+}  // namespace stats
+}  // namespace puddle
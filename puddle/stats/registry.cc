@@ -0,0 +1,23 @@
+#include "puddle/stats/registry.h"
+
+#include <algorithm>
+
+namespace puddle {
+namespace stats {
+
+void Registry::Unregister(const void* metric) {
+  std::lock_guard<std::mutex> lock(mu_);
+  metrics_.erase(
+      std::remove_if(metrics_.begin(), metrics_.end(),
+                     [metric](const MetricInfo& info) {
+                       return std::visit(
+                           [metric](const auto* m) {
+                             return static_cast<const void*>(m) == metric;
+                           },
+                           info.metric);
+                     }),
+      metrics_.end());
+}
+
+}  // namespace stats
+}  // namespace puddle
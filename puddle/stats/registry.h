@@ -0,0 +1,84 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "puddle/stats/concurrent_histogram.h"
+#include "puddle/stats/histogram.h"
+#include "puddle/stats/local_histogram.h"
+#include "puddle/stats/metrics.h"
+
+namespace puddle {
+namespace stats {
+
+// Metric label names and values, such as {"reactor", "0"}.
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+// Describes a registered metric.
+struct MetricInfo {
+  // Metric name, such as "puddle_reactor_spawns_total".
+  std::string name;
+
+  std::string help;
+
+  Labels labels;
+
+  // Histogram metrics are read by the thread reading the registry, so must
+  // only be registered if they are updated on that thread (such as on the
+  // same reactor as the exporter). Use LocalHistogram or
+  // ConcurrentHistogram otherwise.
+  std::variant<const Counter*, const Gauge*, const ConcurrentHistogram*,
+               const LocalHistogram*, const Histogram*>
+      metric;
+};
+
+// Tracks metrics so they can be exported.
+//
+// Metrics are owned by their users (such as the reactor) and registered by
+// address, so must be unregistered before being destroyed. Multiple metrics
+// may have the same name with different labels, such as a metric per
+// reactor.
+//
+// The registry is thread safe. Only registering, unregistering and reading
+// metrics takes the registry lock, so recording metrics is unaffected.
+class Registry {
+ public:
+  template <typename T>
+  void Register(std::string name, std::string help, Labels labels,
+                const T* metric) {
+    std::lock_guard<std::mutex> lock(mu_);
+    metrics_.push_back(MetricInfo{std::move(name), std::move(help),
+                                  std::move(labels), metric});
+  }
+
+  // Unregisters the metric with the given address.
+  void Unregister(const void* metric);
+
+  // Calls fn with each registered metric. The registry lock is held while
+  // calling fn, so metrics can't be unregistered (and destroyed) while being
+  // read.
+  template <typename Fn>
+  void ForEach(Fn&& fn) {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (const MetricInfo& info : metrics_) {
+      fn(info);
+    }
+  }
+
+  // Returns the global registry.
+  static Registry* global() {
+    static Registry registry;
+    return &registry;
+  }
+
+ private:
+  std::mutex mu_;
+
+  std::vector<MetricInfo> metrics_;
+};
+
+}  // namespace stats
+}  // namespace puddle
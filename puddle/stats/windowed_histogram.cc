@@ -0,0 +1,56 @@
+#include "puddle/stats/windowed_histogram.h"
+
+#include <stdexcept>
+
+namespace puddle {
+namespace stats {
+
+namespace {
+
+// Returns slots if positive, so it is checked before allocating the slots.
+int CheckSlots(int slots) {
+  if (slots <= 0) {
+    throw std::invalid_argument{"windowed histogram: slots must be positive"};
+  }
+  return slots;
+}
+
+}  // namespace
+
+WindowedHistogram::WindowedHistogram(
+    int slots, std::chrono::steady_clock::duration slot_size)
+    : slot_size_{slot_size}, slots_(CheckSlots(slots), Slot{-1, Histogram{}}) {
+  if (slot_size_.count() <= 0) {
+    throw std::invalid_argument{
+        "windowed histogram: slot size must be positive"};
+  }
+}
+
+void WindowedHistogram::Add(uint64_t value,
+                            std::chrono::steady_clock::time_point now) {
+  int64_t period = Period(now);
+  Slot& slot = slots_[period % slots_.size()];
+  if (slot.period != period) {
+    // The slot holds samples from a previous window so reset it.
+    slot.period = period;
+    slot.histogram = Histogram{};
+  }
+  slot.histogram.Add(value);
+}
+
+Histogram WindowedHistogram::Snapshot(
+    std::chrono::steady_clock::time_point now) const {
+  int64_t period = Period(now);
+  int64_t oldest = period - static_cast<int64_t>(slots_.size()) + 1;
+
+  Histogram h;
+  for (const Slot& slot : slots_) {
+    if (slot.period >= oldest && slot.period <= period) {
+      h.Merge(slot.histogram);
+    }
+  }
+  return h;
+}
+
+}  // namespace stats
+}  // namespace puddle
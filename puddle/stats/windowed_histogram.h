@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "puddle/stats/histogram.h"
+
+namespace puddle {
+namespace stats {
+
+// WindowedHistogram is a histogram of the samples added within a recent
+// window, such as the last 60 seconds, so percentiles reflect current
+// behaviour rather than the whole process lifetime.
+//
+// The window is split into slots (such as 60 slots of 1 second), each with
+// its own Histogram. Samples are added to the slot for the current time, and
+// once a slot falls out of the window it is cleared and reused. Reading the
+// window merges the slots, so doesn't depend on the number of samples.
+class WindowedHistogram {
+ public:
+  // Throws std::invalid_argument if slots or slot_size isn't positive.
+  WindowedHistogram(int slots, std::chrono::steady_clock::duration slot_size);
+
+  void Add(uint64_t value) { Add(value, std::chrono::steady_clock::now()); }
+
+  // Adds the value at the given time, such as the reactor loop time to avoid
+  // reading the clock.
+  void Add(uint64_t value, std::chrono::steady_clock::time_point now);
+
+  // Returns the merged samples from the window ending at now.
+  Histogram Snapshot(
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now()) const;
+
+ private:
+  struct Slot {
+    // Index of the slot_size period since the clock epoch the slot holds
+    // samples for.
+    int64_t period;
+
+    Histogram histogram;
+  };
+
+  int64_t Period(std::chrono::steady_clock::time_point t) const {
+    return t.time_since_epoch() / slot_size_;
+  }
+
+  std::chrono::steady_clock::duration slot_size_;
+
+  std::vector<Slot> slots_;
+};
+
+}  // namespace stats
+}  // namespace puddle
@@ -33,6 +33,10 @@ class Task {
   template <typename Fn, typename... Arg>
   friend Task Spawn(Fn&& fn, Arg&&... arg);
 
+  template <typename Fn, typename... Arg>
+  friend Task SpawnWithPriority(internal::Priority priority, Fn&& fn,
+                                Arg&&... arg);
+
   Task(boost::intrusive_ptr<internal::Context> context);
 
   boost::intrusive_ptr<internal::Context> context_;